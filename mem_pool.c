@@ -6,6 +6,10 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h> // for perror()
+#include <stdint.h> // for uintptr_t
+#include <string.h> // for strstr()
+#include <unistd.h> // for sysconf()
+#include <sys/mman.h> // for mmap(), mprotect()
 
 #include "mem_pool.h"
 
@@ -14,21 +18,83 @@
 /* Constants */
 /*           */
 /*************/
-static const float      MEM_FILL_FACTOR                 = 0.75;
-static const unsigned   MEM_EXPAND_FACTOR               = 2;
-
 static const unsigned   MEM_POOL_STORE_INIT_CAPACITY    = 20;
 static const float      MEM_POOL_STORE_FILL_FACTOR      = 0.75;
 static const unsigned   MEM_POOL_STORE_EXPAND_FACTOR    = 2;
 
-static const unsigned   MEM_NODE_HEAP_INIT_CAPACITY     = 40;
-static const float      MEM_NODE_HEAP_FILL_FACTOR       = 0.75;
+// note: the node heap grows by whole chunks, which never move; only the
+// array of chunk pointers is expanded
+// note: macros, since they size the chunks
+#define MEM_NODE_HEAP_CHUNK_LOG2    6
+#define MEM_NODE_HEAP_CHUNK_NODES   (1u << MEM_NODE_HEAP_CHUNK_LOG2)
+static const unsigned   MEM_NODE_HEAP_INIT_CHUNKS       = 4;
 static const unsigned   MEM_NODE_HEAP_EXPAND_FACTOR     = 2;
 
+// nodes are referred to by 31-bit index: chunk, then position in chunk
+static const unsigned   MEM_NODE_NIL                    = 0x7fffffff;
+
+static const unsigned   MEM_AVL_NIL                     = (unsigned) -1;
+
 static const unsigned   MEM_GAP_IX_INIT_CAPACITY        = 40;
 static const float      MEM_GAP_IX_FILL_FACTOR          = 0.75;
 static const unsigned   MEM_GAP_IX_EXPAND_FACTOR        = 2;
 
+// note: the same as MEM_AVL_NIL, since the gap index is an AVL tree
+static const unsigned   MEM_GAP_IX_NIL                  = (unsigned) -1;
+
+// note: capacity must stay a power of two
+static const unsigned   MEM_ADDR_IX_INIT_CAPACITY       = 64;
+static const float      MEM_ADDR_IX_FILL_FACTOR         = 0.5;
+static const unsigned   MEM_ADDR_IX_EXPAND_FACTOR       = 2;
+static const unsigned   MEM_ADDR_IX_NIL                 = (unsigned) -1;
+
+// TLSF: first level classes are powers of two, each split linearly into
+// MEM_TLSF_SL_COUNT second level classes (sizes below that share class 0)
+// note: macros, since they size arrays
+#define MEM_TLSF_SL_LOG2    4
+#define MEM_TLSF_SL_COUNT   (1u << MEM_TLSF_SL_LOG2)
+#define MEM_TLSF_FL_COUNT   (64 - MEM_TLSF_SL_LOG2 + 1)
+
+// BUDDY: blocks are powers of two of at least 1 << MEM_BUDDY_MIN_LOG2
+// bytes, enough to chain a free block through its own memory
+#define MEM_BUDDY_MIN_LOG2      4
+#define MEM_BUDDY_ORDER_COUNT   (64 - MEM_BUDDY_MIN_LOG2)
+
+// BITMAP: the pool is divided into granules of 1 << MEM_BITMAP_GRANULE_LOG2
+// bytes, and allocations are rounded up to whole granules
+static const unsigned   MEM_BITMAP_GRANULE_LOG2         = 4;
+
+// huge pages: the size of the ones backing a pool, and where to tell if
+// transparent ones are enabled
+static const size_t     MEM_HUGE_PAGE_SIZE              = (size_t) 2 << 20;
+static const char       MEM_THP_ENABLED_PATH[]          = "/sys/kernel/mm/transparent_hugepage/enabled";
+
+// HUGE_FIT: at most so many gaps in huge pages in use are looked into
+// for a fit
+static const unsigned   MEM_HUGE_MAX_TRIES              = 16;
+
+// deferred frees: pending ones are binned by size, with Fibonacci hashing
+// note: capacity must stay a power of two
+static const unsigned   MEM_QUICK_BIN_COUNT             = 64;
+
+// TAGGED: blocks (header, payload, footer) are multiples of MEM_TAG_ALIGN
+// bytes, and the free ones are binned by the log2 of their payload size
+// note: macro, since it sizes the bins
+#define MEM_TAG_BIN_COUNT   64
+static const size_t     MEM_TAG_ALIGN                   = 16;
+
+// slabs: requests up to max_size (at most MEM_SLAB_MAX_SIZE) are rounded
+// up to classes 1 << MEM_SLAB_CLASS_LOG2 bytes apart, and served from
+// slabs of MEM_SLAB_OBJECTS objects of a class
+// note: a slab is larger than MEM_SLAB_MAX_SIZE, so it is never itself
+// carved out of a slab
+// note: macro, since it sizes the slab records (and is one bit per object)
+#define MEM_SLAB_OBJECTS    64
+static const unsigned   MEM_SLAB_CLASS_LOG2             = 4;
+static const size_t     MEM_SLAB_MAX_SIZE               = 512;
+static const unsigned   MEM_SLAB_IX_INIT_CAPACITY       = 8;
+static const unsigned   MEM_SLAB_IX_EXPAND_FACTOR       = 2;
+
 
 
 /*********************/
@@ -36,27 +102,296 @@ static const unsigned   MEM_GAP_IX_EXPAND_FACTOR        = 2;
 /* Type declarations */
 /*                   */
 /*********************/
+// note: the links are node indices, with the flags packed into their
+// spare bits, so that a node is 24 bytes on 64-bit platforms
+typedef struct _link {
+    unsigned next : 31; // doubly-linked list for gap deletion
+    unsigned allocated : 1;
+    unsigned prev : 31;
+    unsigned used : 1;
+} link_t, *link_pt;
+
 typedef struct _node {
     alloc_t alloc_record;
-    unsigned used;
-    unsigned allocated;
-    struct _node *next, *prev; // doubly-linked list for gap deletion
+    link_t link;
 } node_t, *node_pt;
 
+// the node heap is made of chunks that never move
+// note: a chunk keeps the allocation records and the links in separate
+// dense arrays, so that walks of the list only pull in the links and the
+// records they need; built with MEM_NODE_HEAP_AOS, it is an array of
+// whole nodes instead (see README.md for the trade-off)
+// note: TLSF chunks are followed by the gap index entries of their nodes
+typedef struct _node_chunk {
+#ifndef MEM_NODE_HEAP_AOS
+    alloc_t records[MEM_NODE_HEAP_CHUNK_NODES];
+    link_t links[MEM_NODE_HEAP_CHUNK_NODES];
+#else
+    node_t nodes[MEM_NODE_HEAP_CHUNK_NODES];
+#endif
+    unsigned gaps[];
+} node_chunk_t, *node_chunk_pt;
+
+// the links of an entry of an index (an array) in an AVL tree of its
+// entries, by position, so that the index may move when it grows
+// note: the gap index and the slab index share one AVL implementation,
+// and differ in where the links of an entry are, in how entries are
+// ordered, and in what else a subtree keeps (see avl_ops_t)
+typedef struct _avl_link {
+    unsigned left, right;
+    unsigned height;
+} avl_link_t, *avl_link_pt;
+
+// the gap index is an AVL tree threaded through the gap_ix array,
+// keyed by (size, mem), so that the leftmost sufficient entry is the
+// best fit, and the rightmost one the worst fit; unused entries are
+// chained through link.left
+// note: FIRST_FIT, NEXT_FIT and HUGE_FIT pools key the tree by mem only,
+// and max_size, the largest gap in the subtree, steers the search to the
+// lowest fit (past the rover, for NEXT_FIT, or in a huge page, for HUGE_FIT)
+// note: TLSF pools chain the entries of a size class through link.left
+// (next) and link.right (prev) instead, and each chunk of their node heap
+// is followed by the gap index entries of its nodes, for unlinking
+// note: the mem of a gap is read from its node's record, so that an entry
+// takes 32 bytes, not 40
 typedef struct _gap {
+    avl_link_t link;
+    unsigned node;
     size_t size;
-    node_pt node;
+    size_t max_size;
 } gap_t, *gap_pt;
 
+// the key of a gap in the gap index (mem only, for the policies keyed by it)
+typedef struct _gap_key {
+    size_t size;
+    const char *mem;
+} gap_key_t;
+
+// the address index is an open-addressing (linear probing) hash table
+// from the mem of an allocation to its node in the node heap, so that
+// allocations can be freed by address; empty entries have mem == NULL
+typedef struct _addr {
+    char *mem;
+    unsigned node;
+} addr_t, *addr_pt;
+
+// TLSF size class bitmaps and the heads of the per-class gap lists
+typedef struct _tlsf {
+    unsigned long long fl_bitmap;
+    unsigned sl_bitmap[MEM_TLSF_FL_COUNT];
+    unsigned heads[MEM_TLSF_FL_COUNT][MEM_TLSF_SL_COUNT];
+} tlsf_t, *tlsf_pt;
+
+// a free BUDDY block, chained through its own memory
+typedef struct _buddy_block {
+    struct _buddy_block *next;
+    struct _buddy_block *prev;
+} buddy_block_t, *buddy_block_pt;
+
+// BUDDY free lists, one per order, with a bitmap of the non-empty ones,
+// and for each order a map with one bit per block, set if it is free
+// note: the pool is carved into the largest blocks that fit, in
+// decreasing size, so every block is aligned to its size within the pool
+typedef struct _buddy {
+    size_t arena; // the bytes covered by blocks
+    unsigned orders;
+    unsigned long long order_bitmap;
+    buddy_block_pt heads[MEM_BUDDY_ORDER_COUNT];
+    size_t map_base[MEM_BUDDY_ORDER_COUNT]; // first word of the map of each order
+    unsigned long long *free_map;
+} buddy_t, *buddy_pt;
+
+// a free FIXED block, chained through its own memory
+typedef struct _fixed_block {
+    struct _fixed_block *next;
+} fixed_block_t, *fixed_block_pt;
+
+// FIXED pools: the allocation records of all the blocks, by position
+// in the pool, and the stack of free blocks
+// note: a free block's record has mem == NULL
+typedef struct _fixed {
+    size_t block_size;
+    size_t count;
+    fixed_block_pt free_blocks;
+    alloc_t records[];
+} fixed_t, *fixed_pt;
+
+// RING pools: the live allocations, oldest to newest, are chained
+// through the node links, and the freed ones wait there, unallocated,
+// until they reach the tail (the oldest)
+// note: once the head wraps around to the start of the pool, the space
+// from wrap to the end of the pool is unused until the tail wraps too
+typedef struct _ring {
+    unsigned oldest;
+    unsigned newest;
+    unsigned pending; // freed, not yet reclaimed
+    int wrapped;
+    size_t wrap;
+} ring_t, *ring_pt;
+
+// BITMAP pools: one bit per granule, set if it is used, a second one
+// set at the last granule of each allocation, so that the bits alone
+// tell where an allocation ends, and the number of runs of free granules
+// (each a gap)
+// note: the used bits past the last granule are set, so they are never found
+typedef struct _bitmap {
+    size_t granules;
+    size_t words;
+    unsigned free_runs;
+    unsigned long long *ends; // past the used bits
+    unsigned long long map[];
+} bitmap_t, *bitmap_pt;
+
+// growable pools: the regions added past the first one (pool.mem), each
+// at least region_size bytes, and headed by a region_t, so that the gap
+// of an empty one finds it; their nodes follow those of the regions
+// before in the node list, and never merge with them
+// note: of the regions left empty, only the largest is kept (spare is its
+// node), and the others are freed
+typedef struct _region {
+    struct _region *next;
+    struct _region *prev;
+    size_t size;
+    size_t unused; // keeps the region as aligned as malloc's
+} region_t, *region_pt;
+
+typedef struct _regions {
+    size_t region_size;
+    region_pt head;
+    unsigned count;
+    unsigned spare;
+} regions_t, *regions_pt;
+
+// reserved pools: pool.mem is the start of a range of reserve bytes of
+// address space, of which the first size are in the pool, and the first
+// committed are accessible; both only grow, committed by whole pages,
+// size up to limit
+// note: a pool on huge pages is mapped this way too, all committed, with
+// huge pages for pages, and no room to grow
+// note: if gaps are decommitted, the accessible pages given back to the
+// OS have their bit set in decommitted, until an allocation reaches them,
+// and the gap index keeps count of the whole pages in the gaps of the
+// range, so that the free committed bytes are known without a walk
+typedef struct _reserve {
+    size_t reserve;
+    size_t size;
+    size_t limit;
+    size_t committed;
+    size_t page_size;
+    unsigned last; // the last node of the range
+    size_t retain; // free committed bytes kept
+    size_t freed; // since the last time gaps were decommitted
+    size_t gap_pages;
+    unsigned long long *decommitted; // NULL unless gaps are decommitted
+} reserve_t, *reserve_pt;
+
+// HUGE_FIT pools: the allocated bytes of each huge page the pool spans,
+// from the boundary at or below pool.mem, and a bit per page, set while
+// any of it is allocated
+typedef struct _huge {
+    uintptr_t base;
+    unsigned count;
+    unsigned long long *in_use; // past the counts
+    size_t used[];
+} huge_t, *huge_pt;
+
+// deferred frees: a freed node is left as is in the node list, so that
+// it still looks allocated to its neighbors, and goes on the quick list
+// of its bin, chained through its gap index entry; the pending ones are
+// merged all at once
+typedef struct _quick {
+    unsigned max_pending;
+    unsigned pending;
+    unsigned bins[];
+} quick_t, *quick_pt;
+
+// TAGGED pools: each block starts with its allocation record, whose mem
+// is NULL while the block is free, and ends with a footer holding the
+// payload size, so both neighbors of a block are found by arithmetic;
+// a free block chains through its payload
+typedef struct _tag_link {
+    alloc_pt next;
+    alloc_pt prev;
+} tag_link_t, *tag_link_pt;
+
+// the blocks span region bytes; past it, there is a tail too short for one
+typedef struct _tags {
+    size_t region;
+    unsigned free_blocks;
+    unsigned long long bin_bitmap;
+    alloc_pt bins[MEM_TAG_BIN_COUNT];
+} tags_t, *tags_pt;
+
+// slabs: each one is carved out of one allocation of the pool, and
+// holds the records of its objects, with one bit per object set if it
+// is free; the slabs of a class with free objects are in a list
+typedef struct _slab {
+    alloc_pt backing;
+    unsigned size_class;
+    unsigned ix; // its entry in the slab index
+    avl_link_t link;
+    unsigned long long free_mask;
+    struct _slab *next;
+    struct _slab *prev;
+    alloc_t records[MEM_SLAB_OBJECTS];
+} slab_t, *slab_pt;
+
+// the slab index is an array of all the slabs of a pool, and an AVL tree
+// of those in use, keyed by the mem of their backing, so that the slab of
+// an object is the last one at or below its address, and slabs are added
+// and removed in O(log n)
+// note: released slabs are kept for reuse, chained through next, so that
+// the records of their objects, like node records, never go away; so the
+// links are in the slabs, which never move, not in the array
+typedef struct _slabs {
+    size_t max_size;
+    slab_pt *slab_ix;
+    unsigned slab_ix_capacity;
+    unsigned slab_ix_size;
+    unsigned slab_ix_root;
+    slab_pt spare;
+    slab_pt partial[]; // per class
+} slabs_t, *slabs_pt;
+
 typedef struct _pool_mgr {
     pool_t pool;
-    node_pt node_heap;
+    node_chunk_pt *node_heap;
+    unsigned node_heap_chunks;
+    unsigned node_heap_capacity;
     unsigned total_nodes;
     unsigned used_nodes;
+    unsigned free_nodes; // stack of unused nodes, chained through next
+    unsigned tail; // list policies only: the last node of the list
     gap_pt gap_ix;
     unsigned gap_ix_capacity;
+    unsigned gap_ix_root;
+    unsigned gap_ix_free;
+    addr_pt addr_ix;
+    unsigned addr_ix_capacity;
+    unsigned addr_ix_size;
+    tlsf_pt tlsf; // TLSF pools only
+    huge_pt huge; // HUGE_FIT pools only
+    buddy_pt buddy; // BUDDY pools only
+    fixed_pt fixed; // FIXED pools only
+    ring_t ring; // RING pools only
+    bitmap_pt bitmap; // BITMAP pools only
+    tags_pt tags; // TAGGED pools only
+    quick_pt quick; // NULL unless frees are deferred
+    regions_pt regions; // NULL unless the pool is growable
+    reserve_pt reserve; // NULL unless the pool is reserved
+    char *rover; // NEXT_FIT pools only: where the last allocation ended
+    slabs_pt slabs; // NULL unless slabs are enabled
 } pool_mgr_t, *pool_mgr_pt;
 
+// what tells the AVL trees of the indexes apart: the links of an entry, the
+// order of a key and an entry, and what else a subtree keeps (NULL if only
+// its height)
+typedef struct _avl_ops {
+    avl_link_pt (*link)(pool_mgr_pt pool_mgr, unsigned entry);
+    int (*cmp)(pool_mgr_pt pool_mgr, const void *key, unsigned entry);
+    void (*update)(pool_mgr_pt pool_mgr, unsigned entry);
+} avl_ops_t, *avl_ops_pt;
+
 
 
 /***************************/
@@ -76,17 +411,129 @@ static unsigned pool_store_capacity = 0;
 /*                                          */
 /********************************************/
 static alloc_status _mem_resize_pool_store();
+static pool_pt _mem_pool_open(size_t size, size_t reserve, int huge, alloc_policy policy);
+static alloc_status _mem_reserve(pool_mgr_pt pool_mgr, size_t size, size_t reserve);
+static alloc_status _mem_map_huge(pool_mgr_pt pool_mgr, size_t size);
+static int _mem_thp_enabled();
+static alloc_status _mem_huge_init(pool_mgr_pt pool_mgr, size_t size);
+static void _mem_huge_update(pool_mgr_pt pool_mgr, const char *mem, size_t size, int allocated);
+static unsigned _mem_huge_next_in_use(huge_pt huge, unsigned page);
+static unsigned _mem_huge_find(pool_mgr_pt pool_mgr, size_t size);
+static alloc_status _mem_commit(pool_mgr_pt pool_mgr, const char *mem, size_t size);
+static alloc_status _mem_grow_reserve(pool_mgr_pt pool_mgr, size_t size);
+static void _mem_free_pool_mem(pool_mgr_pt pool_mgr);
+static void _mem_decommit_gaps(pool_mgr_pt pool_mgr);
+static size_t _mem_decommit_pages(pool_mgr_pt pool_mgr, alloc_pt gap);
+static size_t _mem_gap_pages(pool_mgr_pt pool_mgr, const char *mem, size_t size);
+static size_t _mem_free_committed(pool_mgr_pt pool_mgr);
+static int _mem_list_policy(alloc_policy policy);
+static int _mem_bump_policy(alloc_policy policy);
+static void _mem_bump_rollback(pool_mgr_pt pool_mgr, size_t alloc_size, unsigned num_allocs);
+static size_t _mem_ring_place(pool_mgr_pt pool_mgr, size_t size);
+static void _mem_ring_reclaim(pool_mgr_pt pool_mgr);
+static void _mem_ring_count_gaps(pool_mgr_pt pool_mgr);
+static alloc_status _mem_bitmap_init(pool_mgr_pt pool_mgr);
+static int _mem_bitmap_used(pool_mgr_pt pool_mgr, size_t granule);
+static size_t _mem_bitmap_find(pool_mgr_pt pool_mgr, size_t count);
+static char *_mem_bitmap_alloc(pool_mgr_pt pool_mgr, size_t size);
+static alloc_status _mem_bitmap_free(pool_mgr_pt pool_mgr, char *mem);
+static size_t _mem_bitmap_run(pool_mgr_pt pool_mgr, size_t granule);
+static size_t _mem_bitmap_next_used(pool_mgr_pt pool_mgr, size_t granule);
+static void _mem_bitmap_mark(pool_mgr_pt pool_mgr, size_t first, size_t count, int used);
+static void _mem_bitmap_count_gaps(pool_mgr_pt pool_mgr);
+static alloc_status _mem_add_region(pool_mgr_pt pool_mgr, size_t size);
+static alloc_status _mem_release_region(pool_mgr_pt pool_mgr, unsigned node);
+static alloc_status _mem_merge_gap(pool_mgr_pt pool_mgr, unsigned node);
+static unsigned _mem_quick_bin(size_t size);
+static alloc_pt _mem_quick_take(pool_mgr_pt pool_mgr, size_t size);
+static alloc_status _mem_quick_flush(pool_mgr_pt pool_mgr);
+static alloc_status _mem_tag_init(pool_mgr_pt pool_mgr);
+static size_t _mem_tag_payload(size_t size);
+static size_t *_mem_tag_footer(alloc_pt block);
+static alloc_pt _mem_tag_next(pool_mgr_pt pool_mgr, alloc_pt block);
+static alloc_pt _mem_tag_prev(pool_mgr_pt pool_mgr, alloc_pt block);
+static void _mem_tag_write(alloc_pt block, size_t payload, int allocated);
+static unsigned _mem_tag_bin(size_t payload);
+static void _mem_tag_insert(pool_mgr_pt pool_mgr, alloc_pt block);
+static void _mem_tag_remove(pool_mgr_pt pool_mgr, alloc_pt block);
+static alloc_pt _mem_tag_find(pool_mgr_pt pool_mgr, size_t payload);
+static void _mem_tag_count_gaps(pool_mgr_pt pool_mgr);
+static alloc_pt _mem_slab_alloc(pool_mgr_pt pool_mgr, size_t size);
+static alloc_status _mem_slab_free(pool_mgr_pt pool_mgr, slab_pt slab, alloc_pt alloc);
+static slab_pt _mem_slab_create(pool_mgr_pt pool_mgr, unsigned size_class);
+static void _mem_slab_release(pool_mgr_pt pool_mgr, slab_pt slab);
+static slab_pt _mem_slab_find(pool_mgr_pt pool_mgr, const char *mem);
+static avl_link_pt _mem_slab_link(pool_mgr_pt pool_mgr, unsigned slab);
+static int _mem_slab_cmp(pool_mgr_pt pool_mgr, const void *key, unsigned slab);
+static alloc_status _mem_open_side_tables(pool_mgr_pt pool_mgr);
 static alloc_status _mem_resize_node_heap(pool_mgr_pt pool_mgr);
+static alloc_status _mem_add_node_chunk(pool_mgr_pt pool_mgr);
+static void _mem_free_node_heap(pool_mgr_pt pool_mgr);
 static alloc_status _mem_resize_gap_ix(pool_mgr_pt pool_mgr);
+static alloc_status _mem_expand_gap_ix(pool_mgr_pt pool_mgr, unsigned capacity);
+static alloc_status _mem_resize_addr_ix(pool_mgr_pt pool_mgr);
+static alloc_status _mem_rehash_addr_ix(pool_mgr_pt pool_mgr, unsigned capacity);
+static alloc_pt _mem_node_record(pool_mgr_pt pool_mgr, unsigned node);
+static link_pt _mem_node_link(pool_mgr_pt pool_mgr, unsigned node);
+static unsigned *_mem_node_gap(pool_mgr_pt pool_mgr, unsigned node);
+static unsigned _mem_get_node(pool_mgr_pt pool_mgr);
+static void _mem_put_node(pool_mgr_pt pool_mgr, unsigned node);
 static alloc_status
         _mem_add_to_gap_ix(pool_mgr_pt pool_mgr,
                            size_t size,
-                           node_pt node);
+                           unsigned node);
 static alloc_status
         _mem_remove_from_gap_ix(pool_mgr_pt pool_mgr,
                                 size_t size,
-                                node_pt node);
-static alloc_status _mem_sort_gap_ix(pool_mgr_pt pool_mgr);
+                                unsigned node);
+static unsigned _mem_find_in_gap_ix(pool_mgr_pt pool_mgr, size_t size);
+static unsigned _mem_gap_find_first(pool_mgr_pt pool_mgr, size_t size);
+static unsigned _mem_gap_find_next(pool_mgr_pt pool_mgr, size_t size, const char *from);
+static size_t _mem_gap_max_size(pool_mgr_pt pool_mgr, unsigned gap);
+static alloc_pt _mem_gap_record(pool_mgr_pt pool_mgr, unsigned gap);
+static avl_link_pt _mem_gap_link(pool_mgr_pt pool_mgr, unsigned gap);
+static int _mem_gap_cmp(pool_mgr_pt pool_mgr, const void *key, unsigned gap);
+static void _mem_gap_update(pool_mgr_pt pool_mgr, unsigned gap);
+static unsigned _mem_avl_height(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry);
+static void _mem_avl_update(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry);
+static unsigned _mem_avl_rotate_left(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry);
+static unsigned _mem_avl_rotate_right(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry);
+static unsigned _mem_avl_balance(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry);
+static unsigned _mem_avl_insert(const avl_ops_t *ops,
+                                pool_mgr_pt pool_mgr,
+                                unsigned root,
+                                unsigned entry,
+                                const void *key);
+static unsigned _mem_avl_remove(const avl_ops_t *ops,
+                                pool_mgr_pt pool_mgr,
+                                unsigned root,
+                                const void *key,
+                                unsigned *removed);
+static unsigned _mem_avl_remove_min(const avl_ops_t *ops,
+                                    pool_mgr_pt pool_mgr,
+                                    unsigned root,
+                                    unsigned *removed);
+static unsigned _mem_addr_hash(pool_mgr_pt pool_mgr, const char *mem);
+static void _mem_add_to_addr_ix(pool_mgr_pt pool_mgr, char *mem, unsigned node);
+static unsigned _mem_find_in_addr_ix(pool_mgr_pt pool_mgr, const char *mem);
+static void _mem_remove_from_addr_ix(pool_mgr_pt pool_mgr, unsigned slot);
+static void _mem_tlsf_mapping(size_t size, unsigned *fl, unsigned *sl);
+static void _mem_tlsf_insert(pool_mgr_pt pool_mgr, unsigned gap);
+static void _mem_tlsf_remove(pool_mgr_pt pool_mgr, unsigned gap);
+static unsigned _mem_tlsf_find(pool_mgr_pt pool_mgr, size_t size);
+static alloc_status _mem_buddy_init(pool_mgr_pt pool_mgr);
+static void _mem_buddy_release(pool_mgr_pt pool_mgr);
+static unsigned _mem_buddy_order(size_t size);
+static int _mem_buddy_is_free(pool_mgr_pt pool_mgr, size_t offset, unsigned order);
+static void _mem_buddy_push(pool_mgr_pt pool_mgr, size_t offset, unsigned order);
+static void _mem_buddy_unlink(pool_mgr_pt pool_mgr, size_t offset, unsigned order);
+static char *_mem_buddy_alloc(pool_mgr_pt pool_mgr, unsigned order);
+static void _mem_buddy_free(pool_mgr_pt pool_mgr, size_t offset, unsigned order);
+static size_t _mem_buddy_gap_size(pool_mgr_pt pool_mgr, size_t offset);
+
+// the AVL trees of the gap index and of the slab index (see avl_ops_t)
+static const avl_ops_t gap_ix_ops = { _mem_gap_link, _mem_gap_cmp, _mem_gap_update };
+static const avl_ops_t slab_ix_ops = { _mem_slab_link, _mem_slab_cmp, NULL };
 
 
 
@@ -97,463 +544,3434 @@ static alloc_status _mem_sort_gap_ix(pool_mgr_pt pool_mgr);
 /****************************************/
 alloc_status mem_init() {
     // ensure that it's called only once until mem_free
+    if (pool_store != NULL) {
+        return ALLOC_CALLED_AGAIN;
+    }
+
     // allocate the pool store with initial capacity
     // note: holds pointers only, other functions to allocate/deallocate
-
-    pool_store_capacity = MEM_POOL_STORE_INIT_CAPACITY;
-
-    if(pool_store == NULL)
-    {
-        pool_store = (pool_mgr_pt*)calloc(pool_store_size, sizeof(pool_mgr_pt));
-
-
-        if(pool_store == NULL)
-        {
-           printf("Allocation failed.");
-           return ALLOC_CALLED_AGAIN;
-        }
-        else
-        {
-           return ALLOC_OK;
-        }
+    pool_store = (pool_mgr_pt *) calloc(MEM_POOL_STORE_INIT_CAPACITY, sizeof(pool_mgr_pt));
+    if (pool_store == NULL) {
+        perror("mem_init");
+        return ALLOC_FAIL;
     }
+    pool_store_capacity = MEM_POOL_STORE_INIT_CAPACITY;
+    pool_store_size = 0;
 
-    return ALLOC_FAIL;
+    return ALLOC_OK;
 }
 
 alloc_status mem_free() {
     // ensure that it's called only once for each mem_init
+    if (pool_store == NULL) {
+        return ALLOC_CALLED_AGAIN;
+    }
+
     // make sure all pool managers have been deallocated
+    for (unsigned i = 0; i < pool_store_size; ++i) {
+        if (pool_store[i] != NULL) {
+            return ALLOC_NOT_FREED;
+        }
+    }
+
     // can free the pool store array
+    free(pool_store);
+
     // update static variables
+    pool_store = NULL;
+    pool_store_size = 0;
+    pool_store_capacity = 0;
 
-        if(pool_store != NULL)
-    {
-        free(pool_store);
-        pool_store_capacity = 0;
-        return ALLOC_OK;
+    return ALLOC_OK;
+}
+
+pool_pt mem_pool_open(size_t size, alloc_policy policy) {
+    return _mem_pool_open(size, 0, 0, policy);
+}
+
+pool_pt mem_pool_open_reserved(size_t size, size_t reserve, alloc_policy policy) {
+    // only pools that keep their gaps in the node list grow in place
+    if (!_mem_list_policy(policy) || size == 0 || reserve < size) {
+        return NULL;
     }
-    else
-    {
-        printf("Memory already deallocated");
-        return ALLOC_CALLED_AGAIN;
+
+    return _mem_pool_open(size, reserve, 0, policy);
+}
+
+pool_pt mem_pool_open_huge(size_t size, alloc_policy policy) {
+    if (size == 0) {
+        return NULL;
     }
-    return ALLOC_FAIL;
 
-    return ALLOC_FAIL;
+    return _mem_pool_open(size, 0, 1, policy);
 }
 
-pool_pt mem_pool_open(size_t size, alloc_policy policy) {
+pool_pt mem_pool_open_fixed(size_t obj_size, size_t count) {
     // make sure there the pool store is allocated
-    if(pool_store == NULL)
-    {
-        printf("pool store not allocated");
+    if (pool_store == NULL || obj_size == 0 || count == 0 || (unsigned) count != count) {
         return NULL;
     }
-    // expand the pool store, if necessary
-    if(pool_store_size > pool_store_capacity)
-    {
-        pool_store_capacity += MEM_EXPAND_FACTOR;
-    }
-    // allocate a new mem pool mgr
-    pool_mgr_pt mem_pool_mgr = (pool_mgr_pt) malloc(sizeof(pool_mgr_t));
-    // check success, on error return null
-    if(mem_pool_mgr == NULL)
-    {
-        printf("allocation failure");
+
+    // round the block size up, so that a free block holds its link,
+    // aligned, and check the pool size doesn't overflow
+    size_t block_size = (obj_size + sizeof(fixed_block_t) - 1) / sizeof(fixed_block_t)
+                        * sizeof(fixed_block_t);
+    if (block_size < obj_size || block_size > (size_t) -1 / count) {
         return NULL;
     }
-    // allocate a new memory pool
-    mem_pool_mgr->pool.mem = (char*) malloc(size);
 
-    // check success, on error deallocate mgr and return null
-    if(mem_pool_mgr->pool.mem == NULL)
-    {
-        printf("allocation failure");
-        free(mem_pool_mgr);
+    // expand the pool store, if necessary
+    if (_mem_resize_pool_store() != ALLOC_OK) {
         return NULL;
     }
 
-    // allocate a new node heap
-    mem_pool_mgr->node_heap = (node_pt) calloc(MEM_NODE_HEAP_INIT_CAPACITY, sizeof(node_t));
+    // allocate a new mem pool mgr
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) calloc(1, sizeof(pool_mgr_t));
+    // check success, on error return null
+    if (pool_mgr == NULL) {
+        perror("mem_pool_open_fixed");
+        return NULL;
+    }
 
+    // allocate a new memory pool
+    pool_mgr->pool.mem = (char *) malloc(block_size * count);
+    // allocate the records of the blocks
+    // note: no node heap, gap index or address index
+    pool_mgr->fixed = (fixed_pt) calloc(1, sizeof(fixed_t) + count * sizeof(alloc_t));
     // check success, on error deallocate mgr/pool and return null
-    if(mem_pool_mgr->node_heap == NULL)
-    {
-        printf("allocation failure");
-        free(mem_pool_mgr->pool.mem);
-        free(mem_pool_mgr);
+    if (pool_mgr->pool.mem == NULL || pool_mgr->fixed == NULL) {
+        perror("mem_pool_open_fixed");
+        free(pool_mgr->fixed);
+        free(pool_mgr->pool.mem);
+        free(pool_mgr);
         return NULL;
     }
-    // allocate a new gap index
-    mem_pool_mgr->gap_ix = (gap_pt) calloc(MEM_GAP_IX_INIT_CAPACITY, sizeof(gap_t));
-    // check success, on error deallocate mgr/pool/heap and return null
-    if(mem_pool_mgr->node_heap == NULL)
-    {
-        printf("allocation failure");
-        free(mem_pool_mgr->node_heap);
-        free(mem_pool_mgr->pool.mem);
-        free(mem_pool_mgr);
-        return NULL;
+    pool_mgr->fixed->block_size = block_size;
+    pool_mgr->fixed->count = count;
+
+    // stack all the blocks as free, the one at the lowest address on top
+    pool_mgr->fixed->free_blocks = NULL;
+    for (size_t i = count; i > 0; --i) {
+        fixed_block_pt block = (fixed_block_pt) (pool_mgr->pool.mem + (i - 1) * block_size);
+        block->next = pool_mgr->fixed->free_blocks;
+        pool_mgr->fixed->free_blocks = block;
     }
-    // assign all the pointers and update meta data:
-    //   initialize top node of node heap
-    mem_pool_mgr->node_heap[0].alloc_record.size = size;
-    mem_pool_mgr->node_heap[0].alloc_record.mem = mem_pool_mgr->pool.mem;
-    mem_pool_mgr->node_heap[0].used = 0;
-    mem_pool_mgr->node_heap[0].allocated = 0;
-    mem_pool_mgr->node_heap[0].next = NULL;
-    mem_pool_mgr->node_heap[0].prev = NULL;
-
-    //   initialize top node of gap index
-    mem_pool_mgr->gap_ix[0].size = size;
-    mem_pool_mgr->gap_ix[0].node = mem_pool_mgr->node_heap;
 
     //   initialize pool mgr
-    mem_pool_mgr->pool.policy = policy;
-    mem_pool_mgr->pool.num_gaps = 1;
-    mem_pool_mgr->pool.alloc_size = 0;
-    mem_pool_mgr->pool.num_allocs = 0;
-    mem_pool_mgr->pool.total_size = size;
-    mem_pool_mgr->used_nodes = 1;
-    //   link pool mgr to pool store
-
-    int i = 0;
-    while(pool_store[i] != NULL)
-    {
-        pool_store[i] = mem_pool_mgr;
-        pool_store_size = 1;
-        ++i;
-    }
-
+    pool_mgr->pool.policy = FIXED;
+    pool_mgr->pool.total_size = block_size * count;
+    pool_mgr->pool.committed_size = block_size * count;
+    pool_mgr->pool.reserved_size = block_size * count;
+    pool_mgr->pool.alloc_size = 0;
+    pool_mgr->pool.num_allocs = 0;
+    pool_mgr->pool.num_gaps = (unsigned) count;
 
+    //   link pool mgr to pool store
+    pool_store[pool_store_size++] = pool_mgr;
 
     // return the address of the mgr, cast to (pool_pt)
-    return (pool_pt) mem_pool_mgr;
+    return (pool_pt) pool_mgr;
 }
 
 alloc_status mem_pool_close(pool_pt pool) {
     // get mgr from pool by casting the pointer to (pool_mgr_pt)
-    pool_mgr_pt mem_pool_mgr = (pool_mgr_pt)pool;
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
     // check if this pool is allocated
-    if(mem_pool_mgr == NULL)
-    {
-        return ALLOC_NOT_FREED;
+    if (pool_mgr == NULL || pool_store == NULL) {
+        return ALLOC_FAIL;
     }
-    // check if pool has only one gap
-    if(pool->num_gaps > 1)
-    {
-        return ALLOC_NOT_FREED;
+    // merge the pending frees, if they are deferred
+    if (pool_mgr->quick != NULL && _mem_quick_flush(pool_mgr) != ALLOC_OK) {
+        return ALLOC_FAIL;
+    }
+
+    // give the empty slabs back to the pool, if slabs are enabled
+    // note: they are all on the lists of their classes
+    if (pool_mgr->slabs != NULL) {
+        slabs_pt slabs = pool_mgr->slabs;
+        for (unsigned size_class = 0; size_class < slabs->max_size >> MEM_SLAB_CLASS_LOG2; ++size_class) {
+            slab_pt slab = slabs->partial[size_class];
+            while (slab != NULL) {
+                slab_pt next = slab->next;
+                if (slab->free_mask == ~0ull) {
+                    _mem_slab_release(pool_mgr, slab);
+                }
+                slab = next;
+            }
+        }
     }
+
+    // check if pool has only one gap (BUDDY and FIXED pools start with several,
+    // and growable pools have one per region)
     // check if it has zero allocations
-    if(pool->num_gaps > 0);
-    {
+    unsigned regions = pool_mgr->regions != NULL ? 1 + pool_mgr->regions->count : 1;
+    if ((pool->policy != BUDDY && pool->policy != FIXED && pool->num_gaps > regions)
+        || pool->num_allocs > 0) {
         return ALLOC_NOT_FREED;
     }
+
     // free memory pool
-    free(pool);
-    // free node heap
-    free(mem_pool_mgr->node_heap);
-    // free gap index
-    free(mem_pool_mgr->gap_ix);
-    // find mgr in pool store and set to null
-    int i = 0;
-    while(pool_store[i] != mem_pool_mgr)
-    {
-        pool_store[i] = NULL;
-        ++i;
+    _mem_free_pool_mem(pool_mgr);
+    // free node heap, gap index and address index
+    // note: NULL for FIXED and TAGGED pools
+    _mem_free_node_heap(pool_mgr);
+    free(pool_mgr->gap_ix);
+    free(pool_mgr->addr_ix);
+    free(pool_mgr->tlsf);
+    free(pool_mgr->huge);
+    _mem_buddy_release(pool_mgr);
+    free(pool_mgr->fixed);
+    free(pool_mgr->bitmap);
+    free(pool_mgr->tags);
+    free(pool_mgr->quick);
+    if (pool_mgr->regions != NULL) {
+        while (pool_mgr->regions->head != NULL) {
+            region_pt region = pool_mgr->regions->head;
+            pool_mgr->regions->head = region->next;
+            free(region);
+        }
+        free(pool_mgr->regions);
+    }
+    if (pool_mgr->slabs != NULL) {
+        for (unsigned i = 0; i < pool_mgr->slabs->slab_ix_size; ++i) {
+            free(pool_mgr->slabs->slab_ix[i]);
+        }
+        free(pool_mgr->slabs->slab_ix);
+        free(pool_mgr->slabs);
     }
+
+    // find mgr in pool store and set to null
     // note: don't decrement pool_store_size, because it only grows
+    for (unsigned i = 0; i < pool_store_size; ++i) {
+        if (pool_store[i] == pool_mgr) {
+            pool_store[i] = NULL;
+            break;
+        }
+    }
+
     // free mgr
-    free(mem_pool_mgr);
+    free(pool_mgr);
 
     return ALLOC_OK;
 }
 
-alloc_pt mem_new_alloc(pool_pt pool, size_t size) {
+alloc_status mem_pool_reset(pool_pt pool) {
     // get mgr from pool by casting the pointer to (pool_mgr_pt)
-    pool_mgr_pt mem_pool_mgr = (pool_mgr_pt) pool;
-    // check if any gaps, return null if none
-    if(pool->num_gaps == 0)
-    {
-        return NULL;
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
+    // only ARENA and LIFO pools can drop all their allocations at once
+    if (pool_mgr == NULL || !_mem_bump_policy(pool->policy)) {
+        return ALLOC_FAIL;
     }
-    // expand heap node, if necessary, quit on error
-    if(mem_pool_mgr->total_nodes < mem_pool_mgr->used_nodes)
-    {
-        mem_pool_mgr->total_nodes += MEM_NODE_HEAP_EXPAND_FACTOR;
+
+    _mem_bump_rollback(pool_mgr, 0, 0);
+
+    return ALLOC_OK;
+}
+
+pool_mark_t mem_pool_mark(pool_pt pool) {
+    pool_mark_t mark = { 0, 0 };
+
+    // only ARENA and LIFO pools have a top to mark
+    if (pool == NULL || !_mem_bump_policy(pool->policy)) {
+        return mark;
     }
-    // check used nodes fewer than total nodes, quit on error
-    if(mem_pool_mgr->total_nodes < mem_pool_mgr->used_nodes)
-    {
-        return NULL;
+    mark.alloc_size = pool->alloc_size;
+    mark.num_allocs = pool->num_allocs;
+
+    return mark;
+}
+
+alloc_status mem_pool_rollback(pool_pt pool, pool_mark_t mark) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
+    // only ARENA and LIFO pools can drop their latest allocations at once
+    if (pool_mgr == NULL || !_mem_bump_policy(pool->policy)) {
+        return ALLOC_FAIL;
     }
-    // get a node for allocation:
-    node_pt nodeA = NULL;
-    node_pt gapA = NULL;
-    int i = 0;
-    // if FIRST_FIT, then find the first sufficient node in the node heap
-    if(mem_pool_mgr->pool.policy == FIRST_FIT)
-    {
-    while(i < mem_pool_mgr->total_nodes)
-            if((mem_pool_mgr->node_heap[i].allocated != 0 || mem_pool_mgr->node_heap[i].alloc_record.size < size))
-            ++i;
-            nodeA = &mem_pool_mgr->node_heap[i];
+
+    // make sure the mark is not past the top, and that the allocations
+    // below it end where it says, which catches most stale marks
+    if (mark.num_allocs > pool->num_allocs || mark.alloc_size > pool->alloc_size) {
+        return ALLOC_FAIL;
     }
-    // if BEST_FIT, then find the first sufficient node in the gap index
-    if(mem_pool_mgr->pool.policy == BEST_FIT)
-    {
-    while(i < mem_pool_mgr->gap_ix->size)
-            if(i < mem_pool_mgr->pool.num_gaps && mem_pool_mgr->gap_ix[i + 1].size >= size)
-            ++i;
-            nodeA = mem_pool_mgr->gap_ix[i].node;
+    if (mark.num_allocs > 0) {
+        alloc_pt below = _mem_node_record(pool_mgr, mark.num_allocs - 1);
+        if ((size_t) (below->mem + below->size - pool->mem) != mark.alloc_size) {
+            return ALLOC_FAIL;
+        }
+    } else if (mark.alloc_size != 0) {
+        return ALLOC_FAIL;
     }
-    // check if node found
-    if (nodeA = NULL)
-    {
-        return NULL;
+
+    _mem_bump_rollback(pool_mgr, mark.alloc_size, mark.num_allocs);
+
+    return ALLOC_OK;
+}
+
+alloc_status mem_pool_enable_slabs(pool_pt pool, size_t max_size) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
+    // only pools that split and merge gaps get slabs, and only once
+    if (pool_mgr == NULL || pool_mgr->slabs != NULL
+        || !_mem_list_policy(pool->policy)
+        || max_size == 0 || max_size > MEM_SLAB_MAX_SIZE) {
+        return ALLOC_FAIL;
     }
-    // update metadata (num_allocs, alloc_size)
-    (mem_pool_mgr->pool.num_allocs)++;
-    mem_pool_mgr->pool.alloc_size += size;
-    // calculate the size of the remaining gap, if any
-    int remainGap = 0;
-    if(nodeA->alloc_record.size - size > 0)
-    {
-        remainGap = nodeA->alloc_record.size - size;
+
+    // round the limit up to a whole class, and allocate the class lists
+    unsigned classes = (unsigned) ((max_size + ((size_t) 1 << MEM_SLAB_CLASS_LOG2) - 1) >> MEM_SLAB_CLASS_LOG2);
+    slabs_pt slabs = (slabs_pt) calloc(1, sizeof(slabs_t) + classes * sizeof(slab_pt));
+    if (slabs == NULL) {
+        perror("mem_pool_enable_slabs");
+        return ALLOC_FAIL;
     }
-    // remove node from gap index
-    _mem_remove_from_gap_ix(mem_pool_mgr, size, nodeA);
-    // convert gap_node to an allocation node of given size
-    nodeA->alloc_record.size = size;
-    nodeA->allocated = 1;
-    nodeA->used = 1;
-    // adjust node heap:
-    //   if remaining gap, need a new node
-    //   find an unused one in the node heap
-    //   make sure one was found
-    //   initialize it to a gap node
-    int j = 0;
-    if(remainGap > 0)
-    {
-        while(mem_pool_mgr->node_heap[j].used > 0)
-        {
-            gapA = &mem_pool_mgr->node_heap[j];
-            ++j;
-        }
+    slabs->max_size = (size_t) classes << MEM_SLAB_CLASS_LOG2;
+
+    // allocate the slab index, with no slabs yet
+    slabs->slab_ix = (slab_pt *) calloc(MEM_SLAB_IX_INIT_CAPACITY, sizeof(slab_pt));
+    if (slabs->slab_ix == NULL) {
+        perror("mem_pool_enable_slabs");
+        free(slabs);
+        return ALLOC_FAIL;
     }
+    slabs->slab_ix_capacity = MEM_SLAB_IX_INIT_CAPACITY;
+    slabs->slab_ix_root = MEM_AVL_NIL;
+    pool_mgr->slabs = slabs;
+
+    return ALLOC_OK;
+}
+
+alloc_status mem_pool_enable_growth(pool_pt pool, size_t region_size) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
 
-    //   update metadata (used_nodes)
-    (mem_pool_mgr->used_nodes)++;
-    //   update linked list (new node right after the node for allocation)
-    if(nodeA->next != NULL)
-    {
-        nodeA->next->prev = gapA;
-        gapA->prev = nodeA;
+    // only pools that keep their gaps in the node list grow, and only once
+    if (pool_mgr == NULL || pool_mgr->regions != NULL || !_mem_list_policy(pool->policy)
+        || region_size == 0) {
+        return ALLOC_FAIL;
     }
 
-    //   add to gap index
-    _mem_add_to_gap_ix(mem_pool_mgr, remainGap, gapA);
-    //   check if successful
-    // return allocation record by casting the node to (alloc_pt)
-    return (alloc_pt) nodeA;
+    regions_pt regions = (regions_pt) calloc(1, sizeof(regions_t));
+    if (regions == NULL) {
+        perror("mem_pool_enable_growth");
+        return ALLOC_FAIL;
+    }
+    regions->region_size = region_size;
+    regions->spare = MEM_NODE_NIL;
+    pool_mgr->regions = regions;
 
+    return ALLOC_OK;
 }
 
-alloc_status mem_del_alloc(pool_pt pool, alloc_pt alloc) {
+alloc_status mem_pool_decommit_gaps(pool_pt pool, size_t retain) {
     // get mgr from pool by casting the pointer to (pool_mgr_pt)
-    pool_mgr_pt mem_pool_mgr = (pool_mgr_pt) pool;
-    // get node from alloc by casting the pointer to (node_pt)
-    node_pt node = (node_pt) alloc;
-    // find the node in the node heap
-    for(int i = 0; i< mem_pool_mgr->total_nodes; ++i)
-    {
-        if(node == &mem_pool_mgr->node_heap[i])
-        {
-            node = &mem_pool_mgr->node_heap[i];
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
+    // only reserved pools, and list policy pools on huge pages, commit by
+    // pages, and decommit them, and only once
+    if (pool_mgr == NULL || pool_mgr->reserve == NULL || pool_mgr->reserve->decommitted != NULL
+        || !_mem_list_policy(pool->policy)) {
+        return ALLOC_FAIL;
+    }
+
+    // allocate one bit per page of the reservation
+    reserve_pt reserve = pool_mgr->reserve;
+    size_t pages = reserve->reserve / reserve->page_size;
+    reserve->decommitted = (unsigned long long *) calloc((pages + 63) / 64, sizeof(unsigned long long));
+    if (reserve->decommitted == NULL) {
+        perror("mem_pool_decommit_gaps");
+        return ALLOC_FAIL;
+    }
+    reserve->retain = retain;
+    reserve->freed = 0;
+
+    // count the whole pages in the gaps so far; from now on, the gap index
+    // keeps the count
+    for (unsigned node = 0; node != MEM_NODE_NIL; node = _mem_node_link(pool_mgr, node)->next) {
+        if (!_mem_node_link(pool_mgr, node)->allocated) {
+            alloc_pt record = _mem_node_record(pool_mgr, node);
+            reserve->gap_pages += _mem_gap_pages(pool_mgr, record->mem, record->size);
         }
     }
-    // this is node-to-delete
-    // make sure it's found
-    if(node == NULL)
-    {
+
+    return ALLOC_OK;
+}
+
+alloc_status mem_pool_defer_frees(pool_pt pool, unsigned max_pending) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
+    // only pools that merge gaps on every free defer them, and only once
+    if (pool_mgr == NULL || pool_mgr->quick != NULL
+        || !_mem_list_policy(pool->policy)
+        || max_pending == 0) {
         return ALLOC_FAIL;
     }
-    // convert to gap node
-    // update metadata (num_allocs, alloc_size)
-    mem_pool_mgr->pool.num_allocs--;
-    mem_pool_mgr->pool.alloc_size -= node->alloc_record.size;
-    // if the next node in the list is also a gap, merge into node-to-delete
-    //   remove the next node from gap index
-    //   check success
-    //   add the size to the node-to-delete
-    //   update node as unused
-    //   update metadata (used nodes)
-    //   update linked list:
-    /*
-                    if (next->next) {
-                        next->next->prev = node_to_del;
-                        node_to_del->next = next->next;
-                    } else {
-                        node_to_del->next = NULL;
-                    }
-                    next->next = NULL;
-                    next->prev = NULL;
-     */
 
-    // this merged node-to-delete might need to be added to the gap index
-    // but one more thing to check...
-    // if the previous node in the list is also a gap, merge into previous!
-    //   remove the previous node from gap index
-    //   check success
-    //   add the size of node-to-delete to the previous
-    //   update node-to-delete as unused
-    //   update metadata (used_nodes)
-    //   update linked list
-    /*
-                    if (node_to_del->next) {
-                        prev->next = node_to_del->next;
-                        node_to_del->next->prev = prev;
-                    } else {
-                        prev->next = NULL;
-                    }
-                    node_to_del->next = NULL;
-                    node_to_del->prev = NULL;
-     */
-    //   change the node to add to the previous node!
-    // add the resulting node to the gap index
-    // check success
+    quick_pt quick = (quick_pt) malloc(sizeof(quick_t) + MEM_QUICK_BIN_COUNT * sizeof(unsigned));
+    if (quick == NULL) {
+        perror("mem_pool_defer_frees");
+        return ALLOC_FAIL;
+    }
+    quick->max_pending = max_pending;
+    quick->pending = 0;
+    for (unsigned bin = 0; bin < MEM_QUICK_BIN_COUNT; ++bin) {
+        quick->bins[bin] = MEM_NODE_NIL;
+    }
+    pool_mgr->quick = quick;
 
-    return ALLOC_FAIL;
+    return ALLOC_OK;
 }
 
-void mem_inspect_pool(pool_pt pool,
-                      pool_segment_pt *segments,
-                      unsigned *num_segments) {
-    // get the mgr from the pool
-    pool_mgr_pt mem_pool_mgr = (pool_mgr_pt) pool;
-    node_pt currentNode;
-    // allocate the segments array with size == used_nodes
-    pool_segment_pt segArr = (pool_segment_pt) calloc(mem_pool_mgr->used_nodes, sizeof(pool_segment_t));
-    currentNode = mem_pool_mgr->node_heap;
+alloc_status mem_pool_reserve_metadata(pool_pt pool, unsigned max_allocs) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
 
-    // loop through the node heap and the segments array
-    for(int i=0; i < mem_pool_mgr->used_nodes; ++i)
-    {
-        segArr[i].size = currentNode->alloc_record.size;
-        segArr[i].allocated = currentNode->allocated;
-        if(currentNode->next != NULL)
-        {
-            currentNode = currentNode->next;
+    // only pools with a node list, a gap index and an address index
+    // note: the limit keeps the capacities below clear of overflow
+    if (pool_mgr == NULL || !_mem_list_policy(pool->policy)
+        || max_allocs == 0 || max_allocs > MEM_NODE_NIL / 4) {
+        return ALLOC_FAIL;
+    }
+
+    // with max_allocs allocations, a pool of one region has at most
+    // max_allocs + 1 gaps, so a node for each is enough
+    while (pool_mgr->total_nodes < 2 * max_allocs + 1) {
+        if (_mem_add_node_chunk(pool_mgr) != ALLOC_OK) {
+            return ALLOC_FAIL;
         }
     }
-    //    for each node, write the size and allocated in the segment
-    // "return" the values:
-    *segments = segArr;
-    *num_segments = mem_pool_mgr->used_nodes;
 
+    // grow both indices until they stay within their fill factors
+    // note: by the same factors as they would grow on their own
+    unsigned capacity = pool_mgr->gap_ix_capacity;
+    while ((float) (max_allocs + 1) / capacity > MEM_GAP_IX_FILL_FACTOR) {
+        capacity *= MEM_GAP_IX_EXPAND_FACTOR;
+    }
+    if (capacity > pool_mgr->gap_ix_capacity && _mem_expand_gap_ix(pool_mgr, capacity) != ALLOC_OK) {
+        return ALLOC_FAIL;
+    }
+    capacity = pool_mgr->addr_ix_capacity;
+    while ((float) (max_allocs + 1) / capacity > MEM_ADDR_IX_FILL_FACTOR) {
+        capacity *= MEM_ADDR_IX_EXPAND_FACTOR;
+    }
+    if (capacity > pool_mgr->addr_ix_capacity && _mem_rehash_addr_ix(pool_mgr, capacity) != ALLOC_OK) {
+        return ALLOC_FAIL;
+    }
+
+    return ALLOC_OK;
 }
 
+alloc_pt mem_new_alloc(pool_pt pool, size_t size) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
 
+    // if slabs are enabled, then serve a small request from a slab
+    // note: before the gap check, since a full pool may have free objects
+    if (pool_mgr->slabs != NULL && size > 0 && size <= pool_mgr->slabs->max_size) {
+        return _mem_slab_alloc(pool_mgr, size);
+    }
 
-/***********************************/
-/*                                 */
-/* Definitions of static functions */
-/*                                 */
-/***********************************/
-static alloc_status _mem_resize_pool_store() {
-    // check if necessary
-    if (((float) pool_store_size / pool_store_capacity)> MEM_POOL_STORE_FILL_FACTOR)
-        {
-            pool_store = realloc(pool_store, (sizeof(pool_store)* MEM_POOL_STORE_EXPAND_FACTOR));
-            pool_store = pool_store_capacity * MEM_POOL_STORE_EXPAND_FACTOR;
-            return ALLOC_OK;
+    // check if any gaps, return null if none (unless the pool can grow)
+    if ((pool->num_gaps == 0 && pool_mgr->regions == NULL
+         && (pool_mgr->reserve == NULL || pool_mgr->reserve->size == pool_mgr->reserve->limit))
+        || size == 0) {
+        return NULL;
+    }
+
+    // if FIXED, then pop a block off the free stack
+    if (pool->policy == FIXED) {
+        fixed_pt fixed = pool_mgr->fixed;
+        if (size > fixed->block_size) {
+            return NULL;
         }
+        fixed_block_pt block = fixed->free_blocks;
+        fixed->free_blocks = block->next;
+        alloc_pt record = &fixed->records[((char *) block - pool->mem) / fixed->block_size];
+        record->mem = (char *) block;
+        record->size = fixed->block_size;
+        pool->num_allocs++;
+        pool->num_gaps--;
+        pool->alloc_size += fixed->block_size;
+        return record;
+    }
 
-    // don't forget to update capacity variables
+    // if TAGGED, then split a free block from the bins; the header of
+    // the block is the allocation record
+    if (pool->policy == TAGGED) {
+        if (size > pool->total_size) {
+            return NULL;
+        }
+        tags_pt tags = pool_mgr->tags;
+        size_t payload = _mem_tag_payload(size);
+        alloc_pt block = _mem_tag_find(pool_mgr, payload);
+        if (block == NULL) {
+            return NULL;
+        }
+        _mem_tag_remove(pool_mgr, block);
+        // split off the rest, if it's enough for a block
+        size_t rest = block->size - payload;
+        if (rest >= _mem_tag_payload(1) + sizeof(alloc_t) + sizeof(size_t)) {
+            _mem_tag_write(block, payload, 1);
+            alloc_pt next = _mem_tag_next(pool_mgr, block);
+            _mem_tag_write(next, rest - sizeof(alloc_t) - sizeof(size_t), 0);
+            _mem_tag_insert(pool_mgr, next);
+        } else {
+            _mem_tag_write(block, block->size, 1);
+            tags->free_blocks--;
+        }
+        pool->num_allocs++;
+        pool->alloc_size += sizeof(alloc_t) + block->size + sizeof(size_t);
+        _mem_tag_count_gaps(pool_mgr);
+        return block;
+    }
 
+    // expand heap node, if necessary, quit on error
+    if (_mem_resize_node_heap(pool_mgr) != ALLOC_OK) {
+        return NULL;
+    }
+    // if ARENA or LIFO, then bump: the allocation starts where the last
+    // one ended, and its record is the next node of the node heap
+    if (_mem_bump_policy(pool->policy)) {
+        if (size > pool->total_size - pool->alloc_size) {
+            return NULL;
+        }
+        alloc_pt record = _mem_node_record(pool_mgr, pool_mgr->used_nodes++);
+        record->mem = pool->mem + pool->alloc_size;
+        record->size = size;
+        pool->num_allocs++;
+        pool->alloc_size += size;
+        pool->num_gaps = pool->alloc_size < pool->total_size;
+        return record;
+    }
 
-    return ALLOC_FAIL;
-}
+    // check used nodes fewer than total nodes, quit on error
+    if (pool_mgr->free_nodes == MEM_NODE_NIL) {
+        return NULL;
+    }
+    // expand the address index, if necessary, quit on error
+    if (_mem_resize_addr_ix(pool_mgr) != ALLOC_OK) {
+        return NULL;
+    }
 
-static alloc_status _mem_resize_node_heap(pool_mgr_pt pool_mgr) {
-    // see above
-    if (((float) pool_mgr->used_nodes / pool_mgr->total_nodes)> MEM_NODE_HEAP_FILL_FACTOR)
-    {
-        pool_mgr->node_heap = realloc(pool_mgr->node_heap, sizeof(pool_mgr->node_heap) * MEM_NODE_HEAP_EXPAND_FACTOR);
-        pool_mgr->total_nodes = pool_mgr->total_nodes * MEM_NODE_HEAP_EXPAND_FACTOR;
+    // if frees are deferred, then reuse a pending one of the same size
+    if (pool_mgr->quick != NULL) {
+        alloc_pt record = _mem_quick_take(pool_mgr, size);
+        if (record != NULL) {
+            return record;
+        }
+    }
 
-        return ALLOC_OK;
+    // if BUDDY, then take a block of the smallest sufficient order off the
+    // free lists, splitting a larger one if necessary; its node only
+    // holds the allocation record
+    if (pool->policy == BUDDY) {
+        unsigned order = _mem_buddy_order(size);
+        char *mem = _mem_buddy_alloc(pool_mgr, order);
+        if (mem == NULL) {
+            return NULL;
+        }
+        unsigned node = _mem_get_node(pool_mgr);
+        alloc_pt record = _mem_node_record(pool_mgr, node);
+        record->mem = mem;
+        record->size = (size_t) 1 << (MEM_BUDDY_MIN_LOG2 + order);
+        _mem_node_link(pool_mgr, node)->allocated = 1;
+        _mem_add_to_addr_ix(pool_mgr, mem, node);
+        pool->num_allocs++;
+        pool->alloc_size += record->size;
+        return record;
     }
-    return ALLOC_FAIL;
-}
 
-static alloc_status _mem_resize_gap_ix(pool_mgr_pt pool_mgr) {
-    // see above
-if (((float) pool_mgr->pool.num_gaps / pool_mgr->gap_ix_capacity)> MEM_GAP_IX_FILL_FACTOR)
-    {
-        pool_mgr->gap_ix = realloc(pool_mgr->gap_ix, sizeof(pool_mgr->gap_ix) * MEM_GAP_IX_EXPAND_FACTOR);
-        pool_mgr->gap_ix_capacity = pool_mgr->gap_ix_capacity * MEM_GAP_IX_EXPAND_FACTOR;
-        return ALLOC_OK;
+    // if BITMAP, then take the granules, and a node for the allocation
+    // record, since the caller holds on to it
+    // note: mem_new_alloc_addr takes the granules alone
+    if (pool->policy == BITMAP) {
+        char *mem = _mem_bitmap_alloc(pool_mgr, size);
+        if (mem == NULL) {
+            return NULL;
+        }
+        unsigned node = _mem_get_node(pool_mgr);
+        alloc_pt record = _mem_node_record(pool_mgr, node);
+        record->mem = mem;
+        record->size = _mem_bitmap_run(pool_mgr, (size_t) (mem - pool->mem) >> MEM_BITMAP_GRANULE_LOG2)
+                       << MEM_BITMAP_GRANULE_LOG2;
+        _mem_node_link(pool_mgr, node)->allocated = 1;
+        _mem_add_to_addr_ix(pool_mgr, record->mem, node);
+        return record;
     }
-    return ALLOC_FAIL;
-}
 
-static alloc_status _mem_add_to_gap_ix(pool_mgr_pt pool_mgr,
-                                       size_t size,
-                                       node_pt node) {
-    int i = 0;
-    // expand the gap index, if necessary (call the function)
-    _mem_resize_gap_ix(pool_mgr);
-    // add the entry at the end
-    pool_mgr->gap_ix[i].size = size;
-    pool_mgr->gap_ix[i].node = node;
-    // update metadata (num_gaps)
-    (pool_mgr->pool.num_gaps)++;
-    // sort the gap index (call the function)
-    // check success
+    // if RING, then allocate at the head, wrapping around to the start
+    // of the pool if the end is too short, and append the node to the ring
+    if (pool->policy == RING) {
+        size_t offset = _mem_ring_place(pool_mgr, size);
+        if (offset == (size_t) -1) {
+            return NULL;
+        }
+        unsigned node = _mem_get_node(pool_mgr);
+        alloc_pt record = _mem_node_record(pool_mgr, node);
+        link_pt link = _mem_node_link(pool_mgr, node);
+        record->mem = pool->mem + offset;
+        record->size = size;
+        link->allocated = 1;
+        link->prev = pool_mgr->ring.newest;
+        if (pool_mgr->ring.newest != MEM_NODE_NIL) {
+            _mem_node_link(pool_mgr, pool_mgr->ring.newest)->next = node;
+        } else {
+            pool_mgr->ring.oldest = node;
+        }
+        pool_mgr->ring.newest = node;
+        _mem_add_to_addr_ix(pool_mgr, record->mem, node);
+        pool->num_allocs++;
+        pool->alloc_size += size;
+        _mem_ring_count_gaps(pool_mgr);
+        return record;
+    }
 
-    return ALLOC_FAIL;
-}
+    // get a node for allocation:
+    // if FIRST_FIT, then find the sufficient gap at the lowest address
+    // if NEXT_FIT, then the same, but from the end of the last allocation
+    // if BEST_FIT or TLSF, then find the first sufficient node in the gap index
+    // if WORST_FIT, then take the largest gap
+    // if HUGE_FIT, then the same, but in the huge pages in use first
+    unsigned alloc_ix = _mem_find_in_gap_ix(pool_mgr, size);
+
+    // if none, but frees are pending, then merge them and look again
+    if (alloc_ix == MEM_NODE_NIL && pool_mgr->quick != NULL && pool_mgr->quick->pending > 0) {
+        if (_mem_quick_flush(pool_mgr) != ALLOC_OK) {
+            return NULL;
+        }
+        alloc_ix = _mem_find_in_gap_ix(pool_mgr, size);
+    }
 
-static alloc_status _mem_remove_from_gap_ix(pool_mgr_pt pool_mgr,
-                                            size_t size,
-                                            node_pt node) {
-    // find the position of the node in the gap index
-    // loop from there to the end of the array:
-    //    pull the entries (i.e. copy over) one position up
-    //    this effectively deletes the chosen node
-    // update metadata (num_gaps)
-    // zero out the element at position num_gaps!
+    // if still none, but the pool has address space reserved past its end,
+    // then grow it in place and look again
+    if (alloc_ix == MEM_NODE_NIL && pool_mgr->reserve != NULL
+        && _mem_grow_reserve(pool_mgr, size) == ALLOC_OK) {
+        alloc_ix = _mem_find_in_gap_ix(pool_mgr, size);
+    }
 
-    // update metadata (num_gaps)
-    pool_mgr->pool.num_gaps--;
-    // zero out the element at position num_gaps!
-    pool_mgr->gap_ix[i].size = 0;
-    pool_mgr->gap_ix[i].node = NULL;
+    // if still none, but the pool can grow, then add a region and look again
+    if (alloc_ix == MEM_NODE_NIL && pool_mgr->regions != NULL) {
+        if (_mem_add_region(pool_mgr, size) != ALLOC_OK) {
+            return NULL;
+        }
+        alloc_ix = _mem_find_in_gap_ix(pool_mgr, size);
+    }
 
-    return ALLOC_FAIL;
-}
+    // check if node found
+    if (alloc_ix == MEM_NODE_NIL) {
+        return NULL;
+    }
+    alloc_pt alloc_record = _mem_node_record(pool_mgr, alloc_ix);
+    link_pt alloc_link = _mem_node_link(pool_mgr, alloc_ix);
 
-// note: only called by _mem_add_to_gap_ix, which appends a single entry
-static alloc_status _mem_sort_gap_ix(pool_mgr_pt pool_mgr) {
-    // the new entry is at the end, so "bubble it up"
-    // loop from num_gaps - 1 until but not including 0:
-    //    if the size of the current entry is less than the previous (u - 1)
-    //    or if the sizes are the same but the current entry points to a
-    //    node with a lower address of pool allocation address (mem)
-    //       swap them (by copying) (remember to use a temporary variable)
+    // if it is the gap of the empty region kept, then that one is in use again
+    if (pool_mgr->regions != NULL && pool_mgr->regions->spare == alloc_ix) {
+        pool_mgr->regions->spare = MEM_NODE_NIL;
+    }
 
-   gap_t tempNode;
-    int i = pool_mgr->pool.num_gaps - 1;
-    while (pool_mgr->gap_ix[i].size < pool_mgr->gap_ix[i+1].size && i > 0){
-        tempNode = pool_mgr->gap_ix[i];
-        pool_mgr->gap_ix[i] = pool_mgr->gap_ix[i+1];
-        pool_mgr->gap_ix[i+1] = tempNode;
-        --i;
+    // commit the pages it reaches, if the pool is reserved
+    if (pool_mgr->reserve != NULL && _mem_commit(pool_mgr, alloc_record->mem, size) != ALLOC_OK) {
+        return NULL;
     }
-    return ALLOC_OK;
-    return ALLOC_FAIL;
-}
 
+    // calculate the size of the remaining gap, if any
+    size_t remaining_gap = alloc_record->size - size;
 
+    // remove node from gap index
+    if (_mem_remove_from_gap_ix(pool_mgr,
+                                alloc_record->size,
+                                alloc_ix) != ALLOC_OK) {
+        return NULL;
+    }
+
+    // convert gap_node to an allocation node of given size
+    alloc_record->size = size;
+    alloc_link->allocated = 1;
+
+    // update metadata (num_allocs, alloc_size), now that it is taken
+    pool->num_allocs++;
+    pool->alloc_size += size;
+
+    // record it in the address index, and move the rover past it
+    _mem_add_to_addr_ix(pool_mgr, alloc_record->mem, alloc_ix);
+    pool_mgr->rover = alloc_record->mem + size;
+    // count it in its huge pages, if HUGE_FIT
+    if (pool_mgr->huge != NULL) {
+        _mem_huge_update(pool_mgr, alloc_record->mem, size, 1);
+    }
+
+    // adjust node heap:
+    //   if remaining gap, need a new node
+    if (remaining_gap > 0) {
+        //   pop an unused one off the stack (updates used_nodes)
+        unsigned gap_ix = _mem_get_node(pool_mgr);
+        //   make sure one was found
+        if (gap_ix == MEM_NODE_NIL) {
+            return NULL;
+        }
+        //   initialize it to a gap node
+        alloc_pt gap_record = _mem_node_record(pool_mgr, gap_ix);
+        link_pt gap_link = _mem_node_link(pool_mgr, gap_ix);
+        gap_record->size = remaining_gap;
+        gap_record->mem = alloc_record->mem + size;
+        //   update linked list (new node right after the node for allocation)
+        gap_link->prev = alloc_ix;
+        gap_link->next = alloc_link->next;
+        if (alloc_link->next != MEM_NODE_NIL) {
+            _mem_node_link(pool_mgr, alloc_link->next)->prev = gap_ix;
+        }
+        alloc_link->next = gap_ix;
+        if (pool_mgr->tail == alloc_ix) {
+            pool_mgr->tail = gap_ix;
+        }
+        if (pool_mgr->reserve != NULL && pool_mgr->reserve->last == alloc_ix) {
+            pool_mgr->reserve->last = gap_ix;
+        }
+        //   add to gap index
+        //   check if successful
+        if (_mem_add_to_gap_ix(pool_mgr, remaining_gap, gap_ix) != ALLOC_OK) {
+            return NULL;
+        }
+    }
+
+    // return the allocation record of the node
+    return alloc_record;
+}
+
+char *mem_new_alloc_addr(pool_pt pool, size_t size) {
+    // if BITMAP, then the granules are all it takes: the bits tell where
+    // the allocation ends, so it needs no record to be freed
+    if (pool->policy == BITMAP) {
+        return size == 0 ? NULL : _mem_bitmap_alloc((pool_mgr_pt) pool, size);
+    }
+
+    alloc_pt alloc = mem_new_alloc(pool, size);
+
+    return alloc == NULL ? NULL : alloc->mem;
+}
+
+alloc_status mem_del_alloc(pool_pt pool, alloc_pt alloc) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+    if (alloc == NULL) {
+        return ALLOC_FAIL;
+    }
+
+    // if slabs are enabled, then a small allocation may be an object of
+    // a slab (a freed one has no mem, so it is not found)
+    if (pool_mgr->slabs != NULL && alloc->size <= pool_mgr->slabs->max_size) {
+        slab_pt slab = _mem_slab_find(pool_mgr, alloc->mem);
+        if (slab != NULL) {
+            return _mem_slab_free(pool_mgr, slab, alloc);
+        }
+    }
+
+    // if ARENA, then nothing to do: the memory comes back on reset
+    if (pool->policy == ARENA) {
+        return ALLOC_OK;
+    }
+
+    // if LIFO, then only the latest allocation can be popped
+    if (pool->policy == LIFO) {
+        if (pool->num_allocs == 0 || _mem_node_record(pool_mgr, pool->num_allocs - 1) != alloc) {
+            return ALLOC_FAIL;
+        }
+        _mem_bump_rollback(pool_mgr, pool->alloc_size - alloc->size, pool->num_allocs - 1);
+        return ALLOC_OK;
+    }
+
+    // if FIXED, then push the block back on the free stack, after making
+    // sure the record is one of the pool's and is live
+    if (pool->policy == FIXED) {
+        fixed_pt fixed = pool_mgr->fixed;
+        if (alloc < fixed->records || alloc >= fixed->records + fixed->count || alloc->mem == NULL) {
+            return ALLOC_FAIL;
+        }
+        fixed_block_pt block = (fixed_block_pt) alloc->mem;
+        block->next = fixed->free_blocks;
+        fixed->free_blocks = block;
+        alloc->mem = NULL;
+        alloc->size = 0;
+        pool->num_allocs--;
+        pool->num_gaps++;
+        pool->alloc_size -= fixed->block_size;
+        return ALLOC_OK;
+    }
+
+    // if TAGGED, then make sure it's the header of a live block, and
+    // merge it with its free neighbors, found through the tags
+    if (pool->policy == TAGGED) {
+        tags_pt tags = pool_mgr->tags;
+        size_t offset = (size_t) ((char *) alloc - pool->mem);
+        if ((char *) alloc < pool->mem || offset >= tags->region
+            || offset % MEM_TAG_ALIGN != 0 || alloc->mem != (char *) (alloc + 1)) {
+            return ALLOC_FAIL;
+        }
+        pool->num_allocs--;
+        pool->alloc_size -= sizeof(alloc_t) + alloc->size + sizeof(size_t);
+        alloc_pt block = alloc;
+        size_t payload = alloc->size;
+        tags->free_blocks++;
+        alloc_pt next = _mem_tag_next(pool_mgr, alloc);
+        if (next != NULL && next->mem == NULL) {
+            _mem_tag_remove(pool_mgr, next);
+            payload += sizeof(alloc_t) + next->size + sizeof(size_t);
+            tags->free_blocks--;
+        }
+        alloc_pt prev = _mem_tag_prev(pool_mgr, alloc);
+        if (prev != NULL && prev->mem == NULL) {
+            _mem_tag_remove(pool_mgr, prev);
+            payload += sizeof(alloc_t) + prev->size + sizeof(size_t);
+            block = prev;
+            tags->free_blocks--;
+        }
+        // note: the header of a merged block no longer reads as live
+        alloc->mem = NULL;
+        _mem_tag_write(block, payload, 0);
+        _mem_tag_insert(pool_mgr, block);
+        _mem_tag_count_gaps(pool_mgr);
+        return ALLOC_OK;
+    }
+
+    // make sure it's a live allocation of this pool, through the address
+    // index, and get its node: this is node-to-delete
+    // note: node records never move, so a stale one still reads safely
+    unsigned slot = _mem_find_in_addr_ix(pool_mgr, alloc->mem);
+    if (slot == MEM_ADDR_IX_NIL
+        || _mem_node_record(pool_mgr, pool_mgr->addr_ix[slot].node) != alloc) {
+        return ALLOC_FAIL;
+    }
+    unsigned node_ix = pool_mgr->addr_ix[slot].node;
+    alloc_pt node = alloc;
+    link_pt link = _mem_node_link(pool_mgr, node_ix);
+    // drop it from the address index
+    _mem_remove_from_addr_ix(pool_mgr, slot);
+
+    // if BITMAP, then clear its bits, and give back the record's node
+    if (pool->policy == BITMAP) {
+        _mem_put_node(pool_mgr, node_ix);
+        return _mem_bitmap_free(pool_mgr, node->mem);
+    }
+
+    // if RING, then mark it freed, and reclaim what the tail has reached
+    if (pool->policy == RING) {
+        link->allocated = 0;
+        pool->num_allocs--;
+        pool->alloc_size -= node->size;
+        pool_mgr->ring.pending++;
+        _mem_ring_reclaim(pool_mgr);
+        _mem_ring_count_gaps(pool_mgr);
+        return ALLOC_OK;
+    }
+
+    // if BUDDY, then return the block, merging it with its free buddies
+    if (pool->policy == BUDDY) {
+        pool->num_allocs--;
+        pool->alloc_size -= node->size;
+        _mem_buddy_free(pool_mgr, (size_t) (node->mem - pool->mem), _mem_buddy_order(node->size));
+        _mem_put_node(pool_mgr, node_ix);
+        return ALLOC_OK;
+    }
+
+    // update metadata (num_allocs, alloc_size)
+    pool->num_allocs--;
+    pool->alloc_size -= node->size;
+
+    // if frees are deferred, then put it on the quick list of its size,
+    // and merge the pending ones once there are enough
+    if (pool_mgr->quick != NULL) {
+        quick_pt quick = pool_mgr->quick;
+        unsigned bin = _mem_quick_bin(node->size);
+        *_mem_node_gap(pool_mgr, node_ix) = quick->bins[bin];
+        quick->bins[bin] = node_ix;
+        quick->pending++;
+        pool->num_gaps++;
+        return quick->pending < quick->max_pending ? ALLOC_OK : _mem_quick_flush(pool_mgr);
+    }
+
+    // convert to gap node, merging it with its neighbors
+    return _mem_merge_gap(pool_mgr, node_ix);
+}
+
+alloc_status mem_del_alloc_addr(pool_pt pool, char *mem) {
+    // get mgr from pool by casting the pointer to (pool_mgr_pt)
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
+    // if slabs are enabled, then the memory may be an object of a slab,
+    // whose record is found by position
+    if (pool_mgr->slabs != NULL) {
+        slab_pt slab = _mem_slab_find(pool_mgr, mem);
+        if (slab != NULL) {
+            size_t object_size = (size_t) (slab->size_class + 1) << MEM_SLAB_CLASS_LOG2;
+            size_t offset = (size_t) (mem - slab->backing->mem);
+            if (offset % object_size != 0 || offset / object_size >= MEM_SLAB_OBJECTS) {
+                return ALLOC_FAIL;
+            }
+            return mem_del_alloc(pool, &slab->records[offset / object_size]);
+        }
+    }
+
+    // if ARENA, then nothing to do (see mem_del_alloc)
+    if (pool->policy == ARENA) {
+        return mem == NULL ? ALLOC_FAIL : ALLOC_OK;
+    }
+
+    // if LIFO, then it has to be the latest allocation
+    if (pool->policy == LIFO) {
+        if (pool->num_allocs == 0 || _mem_node_record(pool_mgr, pool->num_allocs - 1)->mem != mem) {
+            return ALLOC_FAIL;
+        }
+        return mem_del_alloc(pool, _mem_node_record(pool_mgr, pool->num_allocs - 1));
+    }
+
+    // if TAGGED, then the record is the header right before it
+    if (pool->policy == TAGGED) {
+        if (mem < pool->mem + sizeof(alloc_t) || mem > pool->mem + pool_mgr->tags->region) {
+            return ALLOC_FAIL;
+        }
+        return mem_del_alloc(pool, (alloc_pt) mem - 1);
+    }
+
+    // if FIXED, then the record is found by position, in constant time
+    if (pool->policy == FIXED) {
+        fixed_pt fixed = pool_mgr->fixed;
+        if (mem < pool->mem || mem >= pool->mem + pool->total_size
+            || (size_t) (mem - pool->mem) % fixed->block_size != 0) {
+            return ALLOC_FAIL;
+        }
+        return mem_del_alloc(pool, &fixed->records[(size_t) (mem - pool->mem) / fixed->block_size]);
+    }
+
+    // if BITMAP, then only the allocations made with a record are in
+    // the address index; the others are freed by their bits alone
+    if (pool->policy == BITMAP
+        && (pool_mgr->addr_ix_size == 0 || _mem_find_in_addr_ix(pool_mgr, mem) == MEM_ADDR_IX_NIL)) {
+        return _mem_bitmap_free(pool_mgr, mem);
+    }
+
+    // look up the node of the allocation in the address index
+    unsigned slot = _mem_find_in_addr_ix(pool_mgr, mem);
+    if (slot == MEM_ADDR_IX_NIL) {
+        return ALLOC_FAIL;
+    }
+
+    return mem_del_alloc(pool, _mem_node_record(pool_mgr, pool_mgr->addr_ix[slot].node));
+}
+
+void mem_inspect_pool(pool_pt pool,
+                      pool_segment_pt *segments,
+                      unsigned *num_segments) {
+    // get the mgr from the pool
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) pool;
+
+    // allocate the segments array with size == used_nodes
+    // note: only the policies with a node list have a node per gap
+    unsigned num = _mem_list_policy(pool->policy) ?
+                   pool_mgr->used_nodes : pool->num_allocs + pool->num_gaps;
+    pool_segment_pt segs = (pool_segment_pt) calloc(num, sizeof(pool_segment_t));
+    // check successful
+    if (segs == NULL) {
+        *segments = NULL;
+        *num_segments = 0;
+        return;
+    }
+
+    unsigned i = 0;
+    if (pool->policy == RING && pool_mgr->ring.oldest != MEM_NODE_NIL) {
+        // in address order: the nodes past the wrap, if any, then the gap
+        // before the tail, the nodes from the tail on, and the end gap
+        // note: freed nodes waiting for the tail are gaps of their own
+        ring_pt ring = &pool_mgr->ring;
+        alloc_pt oldest = _mem_node_record(pool_mgr, ring->oldest);
+        alloc_pt newest = _mem_node_record(pool_mgr, ring->newest);
+        size_t tail = (size_t) (oldest->mem - pool->mem);
+        size_t head = (size_t) (newest->mem + newest->size - pool->mem);
+        size_t end = ring->wrapped ? ring->wrap : head;
+        unsigned first = ring->oldest;
+
+        // the first node past the wrap is the one at the start of the pool
+        if (ring->wrapped) {
+            while (_mem_node_record(pool_mgr, first)->mem != pool->mem) {
+                first = _mem_node_link(pool_mgr, first)->next;
+            }
+        }
+        for (unsigned node = first; ring->wrapped && node != MEM_NODE_NIL;
+             node = _mem_node_link(pool_mgr, node)->next) {
+            segs[i].size = _mem_node_record(pool_mgr, node)->size;
+            segs[i++].allocated = _mem_node_link(pool_mgr, node)->allocated;
+        }
+        if ((ring->wrapped ? head : 0) < tail) {
+            segs[i++].size = tail - (ring->wrapped ? head : 0);
+        }
+        for (unsigned node = ring->oldest; node != MEM_NODE_NIL && !(ring->wrapped && node == first);
+             node = _mem_node_link(pool_mgr, node)->next) {
+            segs[i].size = _mem_node_record(pool_mgr, node)->size;
+            segs[i++].allocated = _mem_node_link(pool_mgr, node)->allocated;
+        }
+        if (end < pool->total_size) {
+            segs[i++].size = pool->total_size - end;
+        }
+    } else if (pool->policy == RING) {
+        segs[i++].size = pool->total_size;
+    } else if (pool->policy == TAGGED) {
+        // walk the blocks by their headers; the tail goes with the last
+        // block, if it's free
+        tags_pt tags = pool_mgr->tags;
+        size_t tail = pool->total_size - tags->region;
+        alloc_pt block = tags->region > 0 ? (alloc_pt) pool->mem : NULL;
+        while (block != NULL && i < num) {
+            alloc_pt next = _mem_tag_next(pool_mgr, block);
+            segs[i].size = sizeof(alloc_t) + block->size + sizeof(size_t);
+            segs[i].allocated = block->mem != NULL;
+            if (next == NULL && block->mem == NULL) {
+                segs[i].size += tail;
+                tail = 0;
+            }
+            ++i;
+            block = next;
+        }
+        if (tail > 0 && i < num) {
+            segs[i++].size = tail;
+        }
+    } else if (pool->policy == BITMAP) {
+        // a run of free granules is a gap (with the tail too short for a
+        // granule, at the end), a used granule starts an allocation
+        size_t granules = pool_mgr->bitmap->granules;
+        size_t tail = pool->total_size - (granules << MEM_BITMAP_GRANULE_LOG2);
+        size_t granule = 0;
+        while (granule < granules && i < num) {
+            size_t size;
+            if (_mem_bitmap_used(pool_mgr, granule)) {
+                size_t count = _mem_bitmap_run(pool_mgr, granule);
+                size = count << MEM_BITMAP_GRANULE_LOG2;
+                segs[i].allocated = 1;
+                granule += count;
+            } else {
+                size_t next = _mem_bitmap_next_used(pool_mgr, granule);
+                size = (next - granule) << MEM_BITMAP_GRANULE_LOG2;
+                if (next == granules) {
+                    size += tail;
+                }
+                granule = next;
+            }
+            segs[i++].size = size;
+        }
+        if (tail > 0 && (granules == 0 || _mem_bitmap_used(pool_mgr, granules - 1)) && i < num) {
+            segs[i++].size = tail;
+        }
+    } else if (_mem_bump_policy(pool->policy)) {
+        // the allocations in order, then the rest of the pool, if any
+        for (; i < pool->num_allocs; ++i) {
+            segs[i].size = _mem_node_record(pool_mgr, i)->size;
+            segs[i].allocated = 1;
+        }
+        if (pool->num_gaps > 0) {
+            segs[i++].size = pool->total_size - pool->alloc_size;
+        }
+    } else if (pool->policy == FIXED) {
+        // each block is a segment, allocated if its record is live
+        for (; i < num; ++i) {
+            segs[i].size = pool_mgr->fixed->block_size;
+            segs[i].allocated = pool_mgr->fixed->records[i].mem != NULL;
+        }
+    } else if (pool->policy == BUDDY) {
+        // walk the blocks in address order: a free block is found in the
+        // free maps, an allocated one through the address index
+        size_t offset = 0;
+        while (offset < pool_mgr->buddy->arena && i < num) {
+            size_t size = _mem_buddy_gap_size(pool_mgr, offset);
+            segs[i].allocated = size == 0;
+            if (size == 0) {
+                unsigned slot = _mem_find_in_addr_ix(pool_mgr, pool->mem + offset);
+                assert(slot != MEM_ADDR_IX_NIL);
+                size = _mem_node_record(pool_mgr, pool_mgr->addr_ix[slot].node)->size;
+            }
+            segs[i++].size = size;
+            offset += size;
+        }
+        // the tail too short for a block
+        if (pool->total_size > pool_mgr->buddy->arena && i < num) {
+            segs[i++].size = pool->total_size - pool_mgr->buddy->arena;
+        }
+    } else {
+        // loop through the node heap and the segments array
+        //    for each node, write the size and allocated in the segment
+        for (unsigned node = 0; node != MEM_NODE_NIL; node = _mem_node_link(pool_mgr, node)->next) {
+            segs[i].size = _mem_node_record(pool_mgr, node)->size;
+            segs[i].allocated = _mem_node_link(pool_mgr, node)->allocated;
+            // a pending free still looks allocated, but is a gap
+            if (segs[i].allocated && pool_mgr->quick != NULL
+                && _mem_find_in_addr_ix(pool_mgr, _mem_node_record(pool_mgr, node)->mem) == MEM_ADDR_IX_NIL) {
+                segs[i].allocated = 0;
+            }
+            ++i;
+        }
+    }
+
+    // "return" the values:
+    *segments = segs;
+    *num_segments = num;
+}
+
+
+
+/***********************************/
+/*                                 */
+/* Definitions of static functions */
+/*                                 */
+/***********************************/
+static alloc_status _mem_resize_pool_store() {
+    // check if necessary
+    if (((float) pool_store_size / pool_store_capacity) > MEM_POOL_STORE_FILL_FACTOR) {
+        unsigned capacity = pool_store_capacity * MEM_POOL_STORE_EXPAND_FACTOR;
+        pool_mgr_pt *store = (pool_mgr_pt *) realloc(pool_store, capacity * sizeof(pool_mgr_pt));
+        if (store == NULL) {
+            perror("_mem_resize_pool_store");
+            return ALLOC_FAIL;
+        }
+        // don't forget to update capacity variables
+        pool_store = store;
+        pool_store_capacity = capacity;
+    }
+
+    return ALLOC_OK;
+}
+
+static pool_pt _mem_pool_open(size_t size, size_t reserve, int huge, alloc_policy policy) {
+    // make sure there the pool store is allocated
+    // note: FIXED pools are opened with mem_pool_open_fixed
+    if (pool_store == NULL || policy == FIXED) {
+        return NULL;
+    }
+
+    // expand the pool store, if necessary
+    if (_mem_resize_pool_store() != ALLOC_OK) {
+        return NULL;
+    }
+
+    // allocate a new mem pool mgr
+    pool_mgr_pt pool_mgr = (pool_mgr_pt) calloc(1, sizeof(pool_mgr_t));
+    // check success, on error return null
+    if (pool_mgr == NULL) {
+        perror("mem_pool_open");
+        return NULL;
+    }
+
+    // allocate a new memory pool, or reserve the address space for it, or
+    // map it on huge pages
+    if (reserve > 0 || huge) {
+        if ((huge ? _mem_map_huge(pool_mgr, size) : _mem_reserve(pool_mgr, size, reserve)) != ALLOC_OK) {
+            free(pool_mgr);
+            return NULL;
+        }
+    } else {
+        pool_mgr->pool.mem = (char *) malloc(size);
+    }
+    // check success, on error deallocate mgr and return null
+    if (pool_mgr->pool.mem == NULL) {
+        perror("mem_pool_open");
+        free(pool_mgr);
+        return NULL;
+    }
+
+    // allocate a new node heap, with its first chunk, a new gap index and
+    // a new address index
+    // note: TAGGED pools keep their metadata in the pool itself, and have
+    // none of them (see _mem_tag_init)
+    pool_mgr->pool.policy = policy;
+    pool_mgr->free_nodes = MEM_NODE_NIL;
+    if (policy != TAGGED && _mem_open_side_tables(pool_mgr) != ALLOC_OK) {
+        _mem_free_pool_mem(pool_mgr);
+        free(pool_mgr);
+        return NULL;
+    }
+
+    // assign all the pointers and update meta data:
+    //   initialize top node of node heap
+    //   note: the first one popped, so it is at the top of the first chunk
+    //   note: only the list policies keep their gaps on the node heap
+    unsigned top_node = MEM_NODE_NIL;
+    if (_mem_list_policy(policy)) {
+        top_node = _mem_get_node(pool_mgr);
+        _mem_node_record(pool_mgr, top_node)->size = size;
+        _mem_node_record(pool_mgr, top_node)->mem = pool_mgr->pool.mem;
+    }
+
+    // allocate the TLSF size classes, if needed
+    if (policy == TLSF) {
+        pool_mgr->tlsf = (tlsf_pt) malloc(sizeof(tlsf_t));
+        if (pool_mgr->tlsf == NULL) {
+            perror("mem_pool_open");
+            free(pool_mgr->addr_ix);
+            free(pool_mgr->gap_ix);
+            _mem_free_node_heap(pool_mgr);
+            _mem_free_pool_mem(pool_mgr);
+            free(pool_mgr);
+            return NULL;
+        }
+        pool_mgr->tlsf->fl_bitmap = 0;
+        for (unsigned fl = 0; fl < MEM_TLSF_FL_COUNT; ++fl) {
+            pool_mgr->tlsf->sl_bitmap[fl] = 0;
+            for (unsigned sl = 0; sl < MEM_TLSF_SL_COUNT; ++sl) {
+                pool_mgr->tlsf->heads[fl][sl] = MEM_GAP_IX_NIL;
+            }
+        }
+    }
+
+    // allocate the HUGE_FIT page counts, if needed
+    if (policy == HUGE_FIT && _mem_huge_init(pool_mgr, size) != ALLOC_OK) {
+        free(pool_mgr->addr_ix);
+        free(pool_mgr->gap_ix);
+        _mem_free_node_heap(pool_mgr);
+        _mem_free_pool_mem(pool_mgr);
+        free(pool_mgr);
+        return NULL;
+    }
+
+    //   initialize pool mgr
+    pool_mgr->pool.total_size = size;
+    pool_mgr->pool.alloc_size = 0;
+    pool_mgr->pool.committed_size = pool_mgr->reserve != NULL ? pool_mgr->reserve->committed : size;
+    pool_mgr->pool.reserved_size = pool_mgr->reserve != NULL ? pool_mgr->reserve->reserve : size;
+    pool_mgr->pool.num_allocs = 0;
+    pool_mgr->pool.num_gaps = 0;
+
+    //   initialize top node of gap index, the BUDDY free lists, or the BITMAP
+    //   note: the gap of an ARENA or LIFO pool is what lies past alloc_size
+    alloc_status status = ALLOC_OK;
+    if (policy == BUDDY) {
+        status = _mem_buddy_init(pool_mgr);
+    } else if (_mem_bump_policy(policy)) {
+        pool_mgr->pool.num_gaps = 1;
+    } else if (policy == BITMAP) {
+        status = _mem_bitmap_init(pool_mgr);
+    } else if (policy == TAGGED) {
+        status = _mem_tag_init(pool_mgr);
+    } else if (policy == RING) {
+        pool_mgr->ring.oldest = MEM_NODE_NIL;
+        pool_mgr->ring.newest = MEM_NODE_NIL;
+        pool_mgr->pool.num_gaps = 1;
+    } else {
+        status = _mem_add_to_gap_ix(pool_mgr, size, top_node);
+    }
+    if (status != ALLOC_OK) {
+        free(pool_mgr->tlsf);
+        free(pool_mgr->huge);
+        free(pool_mgr->addr_ix);
+        free(pool_mgr->gap_ix);
+        _mem_free_node_heap(pool_mgr);
+        _mem_free_pool_mem(pool_mgr);
+        free(pool_mgr);
+        return NULL;
+    }
+
+    //   link pool mgr to pool store
+    pool_store[pool_store_size++] = pool_mgr;
+
+    // return the address of the mgr, cast to (pool_pt)
+    return (pool_pt) pool_mgr;
+}
+
+// allocate the node heap, with its first chunk, the gap index, with its
+// free chain, and the address index of a pool; on error, none is left
+static alloc_status _mem_open_side_tables(pool_mgr_pt pool_mgr) {
+    pool_mgr->node_heap = (node_chunk_pt *) calloc(MEM_NODE_HEAP_INIT_CHUNKS, sizeof(node_chunk_pt));
+    pool_mgr->node_heap_capacity = MEM_NODE_HEAP_INIT_CHUNKS;
+    pool_mgr->gap_ix = (gap_pt) calloc(MEM_GAP_IX_INIT_CAPACITY, sizeof(gap_t));
+    pool_mgr->gap_ix_capacity = MEM_GAP_IX_INIT_CAPACITY;
+    pool_mgr->addr_ix = (addr_pt) calloc(MEM_ADDR_IX_INIT_CAPACITY, sizeof(addr_t));
+    pool_mgr->addr_ix_capacity = MEM_ADDR_IX_INIT_CAPACITY;
+    pool_mgr->addr_ix_size = 0;
+    // check success, on error deallocate what was and return fail
+    if (pool_mgr->node_heap == NULL || pool_mgr->gap_ix == NULL || pool_mgr->addr_ix == NULL
+        || _mem_resize_node_heap(pool_mgr) != ALLOC_OK) {
+        perror("mem_pool_open");
+        _mem_free_node_heap(pool_mgr);
+        free(pool_mgr->gap_ix);
+        free(pool_mgr->addr_ix);
+        return ALLOC_FAIL;
+    }
+
+    //   initialize the free chain of the gap index
+    for (unsigned i = 0; i < MEM_GAP_IX_INIT_CAPACITY; ++i) {
+        pool_mgr->gap_ix[i].link.left = i + 1 < MEM_GAP_IX_INIT_CAPACITY ? i + 1 : MEM_GAP_IX_NIL;
+    }
+    pool_mgr->gap_ix_free = 0;
+    pool_mgr->gap_ix_root = MEM_GAP_IX_NIL;
+
+    return ALLOC_OK;
+}
+
+// the policies that keep every gap as a node of the list, and split and
+// merge them
+static int _mem_list_policy(alloc_policy policy) {
+    return policy == FIRST_FIT || policy == NEXT_FIT || policy == BEST_FIT || policy == WORST_FIT
+           || policy == TLSF || policy == HUGE_FIT;
+}
+
+// ARENA and LIFO pools hand out memory by bumping an offset (alloc_size)
+static int _mem_bump_policy(alloc_policy policy) {
+    return policy == ARENA || policy == LIFO;
+}
+
+// drop the allocations above the given ones, all at once
+static void _mem_bump_rollback(pool_mgr_pt pool_mgr, size_t alloc_size, unsigned num_allocs) {
+    // the records are reused from the first dropped node on
+    pool_mgr->used_nodes = num_allocs;
+    // update metadata
+    pool_mgr->pool.num_allocs = num_allocs;
+    pool_mgr->pool.alloc_size = alloc_size;
+    pool_mgr->pool.num_gaps = alloc_size < pool_mgr->pool.total_size;
+}
+
+// the offset at which a RING allocation of size fits, or (size_t) -1
+static size_t _mem_ring_place(pool_mgr_pt pool_mgr, size_t size) {
+    ring_pt ring = &pool_mgr->ring;
+    size_t total = pool_mgr->pool.total_size;
+
+    // an empty ring starts over at the start of the pool
+    if (ring->oldest == MEM_NODE_NIL) {
+        return size <= total ? 0 : (size_t) -1;
+    }
+
+    alloc_pt oldest = _mem_node_record(pool_mgr, ring->oldest);
+    alloc_pt newest = _mem_node_record(pool_mgr, ring->newest);
+    size_t tail = (size_t) (oldest->mem - pool_mgr->pool.mem);
+    size_t head = (size_t) (newest->mem + newest->size - pool_mgr->pool.mem);
+
+    // wrapped: the head can only grow up to the tail
+    if (ring->wrapped) {
+        return size <= tail - head ? head : (size_t) -1;
+    }
+    // not wrapped: up to the end of the pool, else wrap around
+    if (size <= total - head) {
+        return head;
+    }
+    if (size <= tail) {
+        ring->wrapped = 1;
+        ring->wrap = head;
+        return 0;
+    }
+
+    return (size_t) -1;
+}
+
+// pop the freed nodes off the tail of the ring
+static void _mem_ring_reclaim(pool_mgr_pt pool_mgr) {
+    ring_pt ring = &pool_mgr->ring;
+
+    while (ring->oldest != MEM_NODE_NIL && !_mem_node_link(pool_mgr, ring->oldest)->allocated) {
+        unsigned next = _mem_node_link(pool_mgr, ring->oldest)->next;
+        _mem_put_node(pool_mgr, ring->oldest);
+        ring->pending--;
+        ring->oldest = next;
+        if (next != MEM_NODE_NIL) {
+            _mem_node_link(pool_mgr, next)->prev = MEM_NODE_NIL;
+            // the tail wrapped around too
+            if (_mem_node_record(pool_mgr, next)->mem == pool_mgr->pool.mem) {
+                ring->wrapped = 0;
+            }
+        }
+    }
+
+    if (ring->oldest == MEM_NODE_NIL) {
+        ring->newest = MEM_NODE_NIL;
+        ring->wrapped = 0;
+    }
+}
+
+// the gaps are the freed nodes still in the ring, and the free space
+// before the tail, after the head, and (wrapped) past the wrap
+static void _mem_ring_count_gaps(pool_mgr_pt pool_mgr) {
+    ring_pt ring = &pool_mgr->ring;
+    unsigned num_gaps = ring->pending;
+
+    if (ring->oldest == MEM_NODE_NIL) {
+        num_gaps += pool_mgr->pool.total_size > 0;
+    } else {
+        alloc_pt oldest = _mem_node_record(pool_mgr, ring->oldest);
+        alloc_pt newest = _mem_node_record(pool_mgr, ring->newest);
+        size_t tail = (size_t) (oldest->mem - pool_mgr->pool.mem);
+        size_t head = (size_t) (newest->mem + newest->size - pool_mgr->pool.mem);
+
+        if (ring->wrapped) {
+            num_gaps += (head < tail) + (ring->wrap < pool_mgr->pool.total_size);
+        } else {
+            num_gaps += (tail > 0) + (head < pool_mgr->pool.total_size);
+        }
+    }
+
+    pool_mgr->pool.num_gaps = num_gaps;
+}
+
+static alloc_status _mem_resize_node_heap(pool_mgr_pt pool_mgr) {
+    // check if necessary: only when no unused node is left
+    // note: ARENA and LIFO pools take their nodes in order, and never push them back
+    if (_mem_bump_policy(pool_mgr->pool.policy) ?
+        pool_mgr->used_nodes < pool_mgr->total_nodes :
+        pool_mgr->free_nodes != MEM_NODE_NIL) {
+        return ALLOC_OK;
+    }
+
+    return _mem_add_node_chunk(pool_mgr);
+}
+
+static alloc_status _mem_add_node_chunk(pool_mgr_pt pool_mgr) {
+    // check the indices don't run out
+    if (pool_mgr->total_nodes > MEM_NODE_NIL - MEM_NODE_HEAP_CHUNK_NODES) {
+        return ALLOC_FAIL;
+    }
+
+    // expand the array of chunk pointers, if necessary
+    // note: the chunks themselves stay where they are, so neither the
+    // node links, the gap index nor the users' allocation records change
+    if (pool_mgr->node_heap_chunks == pool_mgr->node_heap_capacity) {
+        unsigned capacity = pool_mgr->node_heap_capacity * MEM_NODE_HEAP_EXPAND_FACTOR;
+        node_chunk_pt *heap = (node_chunk_pt *) realloc(pool_mgr->node_heap,
+                                                        capacity * sizeof(node_chunk_pt));
+        if (heap == NULL) {
+            perror("_mem_add_node_chunk");
+            return ALLOC_FAIL;
+        }
+        pool_mgr->node_heap = heap;
+        pool_mgr->node_heap_capacity = capacity;
+    }
+
+    // add a chunk (followed by the gap index entries of its nodes for TLSF,
+    // or the quick list links, if frees get deferred)
+    size_t chunk_size = sizeof(node_chunk_t);
+    if (_mem_list_policy(pool_mgr->pool.policy)) {
+        chunk_size += MEM_NODE_HEAP_CHUNK_NODES * sizeof(unsigned);
+    }
+    node_chunk_pt chunk = (node_chunk_pt) calloc(1, chunk_size);
+    if (chunk == NULL) {
+        perror("_mem_add_node_chunk");
+        return ALLOC_FAIL;
+    }
+    unsigned first = pool_mgr->total_nodes;
+    pool_mgr->node_heap[pool_mgr->node_heap_chunks++] = chunk;
+    pool_mgr->total_nodes += MEM_NODE_HEAP_CHUNK_NODES;
+
+    // stack its nodes as unused, the top one last
+    for (unsigned i = MEM_NODE_HEAP_CHUNK_NODES; i > 0; --i) {
+        _mem_node_link(pool_mgr, first + i - 1)->next = pool_mgr->free_nodes;
+        pool_mgr->free_nodes = first + i - 1;
+    }
+
+    return ALLOC_OK;
+}
+
+// note: FIXED and TAGGED pools have no node heap, so nothing is freed
+static void _mem_free_node_heap(pool_mgr_pt pool_mgr) {
+    for (unsigned i = 0; i < pool_mgr->node_heap_chunks; ++i) {
+        free(pool_mgr->node_heap[i]);
+    }
+    free(pool_mgr->node_heap);
+}
+
+static alloc_status _mem_resize_gap_ix(pool_mgr_pt pool_mgr) {
+    // see above
+    // note: the tree links are indices, so no fix-up is needed
+    if (pool_mgr->gap_ix_free == MEM_GAP_IX_NIL
+        || ((float) pool_mgr->pool.num_gaps / pool_mgr->gap_ix_capacity) > MEM_GAP_IX_FILL_FACTOR) {
+        return _mem_expand_gap_ix(pool_mgr, pool_mgr->gap_ix_capacity * MEM_GAP_IX_EXPAND_FACTOR);
+    }
+
+    return ALLOC_OK;
+}
+
+static alloc_status _mem_expand_gap_ix(pool_mgr_pt pool_mgr, unsigned capacity) {
+    gap_pt gap_ix = (gap_pt) realloc(pool_mgr->gap_ix, capacity * sizeof(gap_t));
+    if (gap_ix == NULL) {
+        perror("_mem_expand_gap_ix");
+        return ALLOC_FAIL;
+    }
+
+    // chain the new entries in front of the free ones
+    for (unsigned i = pool_mgr->gap_ix_capacity; i < capacity; ++i) {
+        gap_ix[i].node = MEM_NODE_NIL;
+        gap_ix[i].link.right = MEM_GAP_IX_NIL;
+        gap_ix[i].link.height = 0;
+        gap_ix[i].max_size = 0;
+        gap_ix[i].link.left = i + 1 < capacity ? i + 1 : pool_mgr->gap_ix_free;
+    }
+    pool_mgr->gap_ix_free = pool_mgr->gap_ix_capacity;
+
+    pool_mgr->gap_ix = gap_ix;
+    pool_mgr->gap_ix_capacity = capacity;
+
+    return ALLOC_OK;
+}
+
+static alloc_status _mem_resize_addr_ix(pool_mgr_pt pool_mgr) {
+    // see above
+    // note: grows ahead of the insertion, so that adding never fails
+    if (((float) (pool_mgr->addr_ix_size + 1) / pool_mgr->addr_ix_capacity) > MEM_ADDR_IX_FILL_FACTOR) {
+        return _mem_rehash_addr_ix(pool_mgr, pool_mgr->addr_ix_capacity * MEM_ADDR_IX_EXPAND_FACTOR);
+    }
+
+    return ALLOC_OK;
+}
+
+static alloc_status _mem_rehash_addr_ix(pool_mgr_pt pool_mgr, unsigned capacity) {
+    addr_pt old_ix = pool_mgr->addr_ix;
+    unsigned old_capacity = pool_mgr->addr_ix_capacity;
+
+    // the slots depend on the capacity, so rehash into a new table
+    addr_pt addr_ix = (addr_pt) calloc(capacity, sizeof(addr_t));
+    if (addr_ix == NULL) {
+        perror("_mem_rehash_addr_ix");
+        return ALLOC_FAIL;
+    }
+    pool_mgr->addr_ix = addr_ix;
+    pool_mgr->addr_ix_capacity = capacity;
+    pool_mgr->addr_ix_size = 0;
+
+    for (unsigned i = 0; i < old_capacity; ++i) {
+        if (old_ix[i].mem != NULL) {
+            _mem_add_to_addr_ix(pool_mgr, old_ix[i].mem, old_ix[i].node);
+        }
+    }
+
+    free(old_ix);
+
+    return ALLOC_OK;
+}
+
+static alloc_pt _mem_node_record(pool_mgr_pt pool_mgr, unsigned node) {
+    node_chunk_pt chunk = pool_mgr->node_heap[node >> MEM_NODE_HEAP_CHUNK_LOG2];
+
+#ifndef MEM_NODE_HEAP_AOS
+    return &chunk->records[node & (MEM_NODE_HEAP_CHUNK_NODES - 1)];
+#else
+    return &chunk->nodes[node & (MEM_NODE_HEAP_CHUNK_NODES - 1)].alloc_record;
+#endif
+}
+
+static link_pt _mem_node_link(pool_mgr_pt pool_mgr, unsigned node) {
+    node_chunk_pt chunk = pool_mgr->node_heap[node >> MEM_NODE_HEAP_CHUNK_LOG2];
+
+#ifndef MEM_NODE_HEAP_AOS
+    return &chunk->links[node & (MEM_NODE_HEAP_CHUNK_NODES - 1)];
+#else
+    return &chunk->nodes[node & (MEM_NODE_HEAP_CHUNK_NODES - 1)].link;
+#endif
+}
+
+// TLSF pools, or pending frees
+static unsigned *_mem_node_gap(pool_mgr_pt pool_mgr, unsigned node) {
+    node_chunk_pt chunk = pool_mgr->node_heap[node >> MEM_NODE_HEAP_CHUNK_LOG2];
+
+    return &chunk->gaps[node & (MEM_NODE_HEAP_CHUNK_NODES - 1)];
+}
+
+static unsigned _mem_get_node(pool_mgr_pt pool_mgr) {
+    unsigned node = pool_mgr->free_nodes;
+
+    if (node != MEM_NODE_NIL) {
+        link_pt entry = _mem_node_link(pool_mgr, node);
+        pool_mgr->free_nodes = entry->next;
+        entry->used = 1;
+        entry->allocated = 0;
+        entry->next = MEM_NODE_NIL;
+        entry->prev = MEM_NODE_NIL;
+        pool_mgr->used_nodes++;
+    }
+
+    return node;
+}
+
+static void _mem_put_node(pool_mgr_pt pool_mgr, unsigned node) {
+    link_pt entry = _mem_node_link(pool_mgr, node);
+
+    entry->used = 0;
+    entry->allocated = 0;
+    entry->prev = MEM_NODE_NIL;
+    entry->next = pool_mgr->free_nodes;
+    pool_mgr->free_nodes = node;
+    pool_mgr->used_nodes--;
+}
+
+static alloc_status _mem_add_to_gap_ix(pool_mgr_pt pool_mgr,
+                                       size_t size,
+                                       unsigned node) {
+    // expand the gap index, if necessary (call the function)
+    if (_mem_resize_gap_ix(pool_mgr) != ALLOC_OK) {
+        return ALLOC_FAIL;
+    }
+
+    // take an unused entry
+    unsigned gap = pool_mgr->gap_ix_free;
+    pool_mgr->gap_ix_free = pool_mgr->gap_ix[gap].link.left;
+
+    pool_mgr->gap_ix[gap].size = size;
+    pool_mgr->gap_ix[gap].node = node;
+    pool_mgr->gap_ix[gap].link.left = MEM_GAP_IX_NIL;
+    pool_mgr->gap_ix[gap].link.right = MEM_GAP_IX_NIL;
+    pool_mgr->gap_ix[gap].link.height = 1;
+    pool_mgr->gap_ix[gap].max_size = size;
+
+    // insert it into the size class list or the tree (keeps the index sorted)
+    if (pool_mgr->pool.policy == TLSF) {
+        *_mem_node_gap(pool_mgr, node) = gap;
+        _mem_tlsf_insert(pool_mgr, gap);
+    } else {
+        gap_key_t key = { size, _mem_node_record(pool_mgr, node)->mem };
+        pool_mgr->gap_ix_root = _mem_avl_insert(&gap_ix_ops, pool_mgr, pool_mgr->gap_ix_root, gap, &key);
+    }
+
+    // update metadata (num_gaps, and the whole pages in gaps, if counted)
+    pool_mgr->pool.num_gaps++;
+    if (pool_mgr->reserve != NULL && pool_mgr->reserve->decommitted != NULL) {
+        pool_mgr->reserve->gap_pages += _mem_gap_pages(pool_mgr, _mem_node_record(pool_mgr, node)->mem, size);
+    }
+
+    return ALLOC_OK;
+}
+
+static alloc_status _mem_remove_from_gap_ix(pool_mgr_pt pool_mgr,
+                                            size_t size,
+                                            unsigned node) {
+    unsigned gap = MEM_GAP_IX_NIL;
+
+    // find the entry and unlink it
+    if (pool_mgr->pool.policy == TLSF) {
+        gap = *_mem_node_gap(pool_mgr, node);
+        if (gap >= pool_mgr->gap_ix_capacity || pool_mgr->gap_ix[gap].node != node) {
+            return ALLOC_FAIL;
+        }
+        _mem_tlsf_remove(pool_mgr, gap);
+    } else {
+        gap_key_t key = { size, _mem_node_record(pool_mgr, node)->mem };
+        pool_mgr->gap_ix_root = _mem_avl_remove(&gap_ix_ops, pool_mgr, pool_mgr->gap_ix_root, &key, &gap);
+        if (gap == MEM_GAP_IX_NIL) {
+            return ALLOC_FAIL;
+        }
+    }
+
+    // update metadata (num_gaps, and the whole pages in gaps, if counted)
+    pool_mgr->pool.num_gaps--;
+    if (pool_mgr->reserve != NULL && pool_mgr->reserve->decommitted != NULL) {
+        pool_mgr->reserve->gap_pages -= _mem_gap_pages(pool_mgr, _mem_node_record(pool_mgr, node)->mem, size);
+    }
+
+    // zero out the entry and return it to the unused ones
+    pool_mgr->gap_ix[gap].node = MEM_NODE_NIL;
+    pool_mgr->gap_ix[gap].link.right = MEM_GAP_IX_NIL;
+    pool_mgr->gap_ix[gap].link.height = 0;
+    pool_mgr->gap_ix[gap].max_size = 0;
+    pool_mgr->gap_ix[gap].link.left = pool_mgr->gap_ix_free;
+    pool_mgr->gap_ix_free = gap;
+
+    return ALLOC_OK;
+}
+
+// multiplicative (Fibonacci) hashing, taking the well-mixed high bits
+static unsigned _mem_addr_hash(pool_mgr_pt pool_mgr, const char *mem) {
+    unsigned long long hash = (unsigned long long) (uintptr_t) mem * 11400714819323198485ull;
+
+    return (unsigned) (hash >> 32) & (pool_mgr->addr_ix_capacity - 1);
+}
+
+static void _mem_add_to_addr_ix(pool_mgr_pt pool_mgr, char *mem, unsigned node) {
+    unsigned mask = pool_mgr->addr_ix_capacity - 1;
+    unsigned slot = _mem_addr_hash(pool_mgr, mem);
+
+    while (pool_mgr->addr_ix[slot].mem != NULL) {
+        slot = (slot + 1) & mask;
+    }
+    pool_mgr->addr_ix[slot].mem = mem;
+    pool_mgr->addr_ix[slot].node = node;
+    pool_mgr->addr_ix_size++;
+}
+
+static unsigned _mem_find_in_addr_ix(pool_mgr_pt pool_mgr, const char *mem) {
+    unsigned mask = pool_mgr->addr_ix_capacity - 1;
+    unsigned slot = _mem_addr_hash(pool_mgr, mem);
+
+    if (mem == NULL) {
+        return MEM_ADDR_IX_NIL;
+    }
+    while (pool_mgr->addr_ix[slot].mem != NULL) {
+        if (pool_mgr->addr_ix[slot].mem == mem) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return MEM_ADDR_IX_NIL;
+}
+
+// backward-shift deletion: pull up the following entries of the probe
+// run that may not stay behind the hole, so no tombstones are needed
+static void _mem_remove_from_addr_ix(pool_mgr_pt pool_mgr, unsigned slot) {
+    unsigned mask = pool_mgr->addr_ix_capacity - 1;
+    unsigned next = (slot + 1) & mask;
+
+    while (pool_mgr->addr_ix[next].mem != NULL) {
+        unsigned home = _mem_addr_hash(pool_mgr, pool_mgr->addr_ix[next].mem);
+        // move the entry, unless its home lies cyclically in (slot, next]
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            pool_mgr->addr_ix[slot] = pool_mgr->addr_ix[next];
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    pool_mgr->addr_ix[slot].mem = NULL;
+    pool_mgr->addr_ix[slot].node = 0;
+    pool_mgr->addr_ix_size--;
+}
+
+// the leftmost entry with sufficient size is the smallest such gap,
+// and among equal sizes the one at the lowest address
+static unsigned _mem_find_in_gap_ix(pool_mgr_pt pool_mgr, size_t size) {
+    unsigned found = MEM_NODE_NIL;
+    unsigned gap = pool_mgr->gap_ix_root;
+
+    if (pool_mgr->pool.policy == TLSF) {
+        gap = _mem_tlsf_find(pool_mgr, size);
+        return gap == MEM_GAP_IX_NIL ? MEM_NODE_NIL : pool_mgr->gap_ix[gap].node;
+    }
+    if (pool_mgr->pool.policy == FIRST_FIT) {
+        gap = _mem_gap_find_first(pool_mgr, size);
+        return gap == MEM_GAP_IX_NIL ? MEM_NODE_NIL : pool_mgr->gap_ix[gap].node;
+    }
+    if (pool_mgr->pool.policy == HUGE_FIT) {
+        gap = _mem_huge_find(pool_mgr, size);
+        return gap == MEM_GAP_IX_NIL ? MEM_NODE_NIL : pool_mgr->gap_ix[gap].node;
+    }
+    // WORST_FIT: the rightmost entry, unless even that is too small
+    // note: the max_size of the root is the largest gap, so a request no
+    // gap can hold is turned down right away
+    if (pool_mgr->pool.policy == WORST_FIT) {
+        if (_mem_gap_max_size(pool_mgr, gap) < size) {
+            return MEM_NODE_NIL;
+        }
+        while (pool_mgr->gap_ix[gap].link.right != MEM_GAP_IX_NIL) {
+            gap = pool_mgr->gap_ix[gap].link.right;
+        }
+        return pool_mgr->gap_ix[gap].node;
+    }
+    // NEXT_FIT: the lowest fit past the rover, or else wrap around
+    if (pool_mgr->pool.policy == NEXT_FIT) {
+        gap = _mem_gap_find_next(pool_mgr, size, pool_mgr->rover);
+        if (gap == MEM_GAP_IX_NIL) {
+            gap = _mem_gap_find_first(pool_mgr, size);
+        }
+        return gap == MEM_GAP_IX_NIL ? MEM_NODE_NIL : pool_mgr->gap_ix[gap].node;
+    }
+
+    while (gap != MEM_GAP_IX_NIL) {
+        if (pool_mgr->gap_ix[gap].size >= size) {
+            found = pool_mgr->gap_ix[gap].node;
+            gap = pool_mgr->gap_ix[gap].link.left;
+        } else {
+            gap = pool_mgr->gap_ix[gap].link.right;
+        }
+    }
+
+    return found;
+}
+
+// the lowest sufficient gap at or past from: the deepest entry past from
+// on the way down that fits, or has a fit to its right, is the one below
+// which it is
+static unsigned _mem_gap_find_next(pool_mgr_pt pool_mgr, size_t size, const char *from) {
+    unsigned found = MEM_GAP_IX_NIL;
+    unsigned gap = pool_mgr->gap_ix_root;
+
+    while (gap != MEM_GAP_IX_NIL) {
+        gap_pt entry = &pool_mgr->gap_ix[gap];
+
+        if (_mem_gap_record(pool_mgr, gap)->mem < from) {
+            gap = entry->link.right;
+        } else {
+            if (pool_mgr->gap_ix[gap].size >= size || _mem_gap_max_size(pool_mgr, entry->link.right) >= size) {
+                found = gap;
+            }
+            gap = entry->link.left;
+        }
+    }
+    if (found == MEM_GAP_IX_NIL || pool_mgr->gap_ix[found].size >= size) {
+        return found;
+    }
+
+    // the lowest fit in its right subtree
+    gap = pool_mgr->gap_ix[found].link.right;
+    while (gap != MEM_GAP_IX_NIL) {
+        gap_pt entry = &pool_mgr->gap_ix[gap];
+
+        if (_mem_gap_max_size(pool_mgr, entry->link.left) >= size) {
+            gap = entry->link.left;
+        } else if (pool_mgr->gap_ix[gap].size >= size) {
+            return gap;
+        } else {
+            gap = entry->link.right;
+        }
+    }
+
+    return MEM_GAP_IX_NIL;
+}
+
+// the first sufficient gap in address order: descend into the left
+// subtree whenever it holds a large enough gap
+static unsigned _mem_gap_find_first(pool_mgr_pt pool_mgr, size_t size) {
+    unsigned gap = pool_mgr->gap_ix_root;
+
+    while (gap != MEM_GAP_IX_NIL && pool_mgr->gap_ix[gap].max_size >= size) {
+        gap_pt entry = &pool_mgr->gap_ix[gap];
+
+        if (_mem_gap_max_size(pool_mgr, entry->link.left) >= size) {
+            gap = entry->link.left;
+        } else if (pool_mgr->gap_ix[gap].size >= size) {
+            return gap;
+        } else {
+            gap = entry->link.right;
+        }
+    }
+
+    return MEM_GAP_IX_NIL;
+}
+
+static avl_link_pt _mem_gap_link(pool_mgr_pt pool_mgr, unsigned gap) {
+    return &pool_mgr->gap_ix[gap].link;
+}
+
+static int _mem_gap_cmp(pool_mgr_pt pool_mgr, const void *key, unsigned gap) {
+    const gap_key_t *gap_key = (const gap_key_t *) key;
+    gap_pt entry = &pool_mgr->gap_ix[gap];
+
+    if (pool_mgr->pool.policy != FIRST_FIT && pool_mgr->pool.policy != NEXT_FIT
+        && pool_mgr->pool.policy != HUGE_FIT && gap_key->size != entry->size) {
+        return gap_key->size < entry->size ? -1 : 1;
+    }
+    const char *entry_mem = _mem_gap_record(pool_mgr, gap)->mem;
+    if (gap_key->mem != entry_mem) {
+        return gap_key->mem < entry_mem ? -1 : 1;
+    }
+    return 0;
+}
+
+static size_t _mem_gap_max_size(pool_mgr_pt pool_mgr, unsigned gap) {
+    return gap == MEM_GAP_IX_NIL ? 0 : pool_mgr->gap_ix[gap].max_size;
+}
+
+static alloc_pt _mem_gap_record(pool_mgr_pt pool_mgr, unsigned gap) {
+    return _mem_node_record(pool_mgr, pool_mgr->gap_ix[gap].node);
+}
+
+static void _mem_gap_update(pool_mgr_pt pool_mgr, unsigned gap) {
+    gap_pt entry = &pool_mgr->gap_ix[gap];
+    size_t ml = _mem_gap_max_size(pool_mgr, entry->link.left);
+    size_t mr = _mem_gap_max_size(pool_mgr, entry->link.right);
+
+    entry->max_size = entry->size;
+    if (ml > entry->max_size) {
+        entry->max_size = ml;
+    }
+    if (mr > entry->max_size) {
+        entry->max_size = mr;
+    }
+}
+
+static unsigned _mem_avl_height(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry) {
+    return entry == MEM_AVL_NIL ? 0 : ops->link(pool_mgr, entry)->height;
+}
+
+static void _mem_avl_update(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry) {
+    avl_link_pt link = ops->link(pool_mgr, entry);
+    unsigned hl = _mem_avl_height(ops, pool_mgr, link->left);
+    unsigned hr = _mem_avl_height(ops, pool_mgr, link->right);
+
+    link->height = (hl > hr ? hl : hr) + 1;
+    if (ops->update != NULL) {
+        ops->update(pool_mgr, entry);
+    }
+}
+
+static unsigned _mem_avl_rotate_left(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry) {
+    avl_link_pt link = ops->link(pool_mgr, entry);
+    unsigned pivot = link->right;
+    avl_link_pt pivot_link = ops->link(pool_mgr, pivot);
+
+    link->right = pivot_link->left;
+    pivot_link->left = entry;
+    _mem_avl_update(ops, pool_mgr, entry);
+    _mem_avl_update(ops, pool_mgr, pivot);
+
+    return pivot;
+}
+
+static unsigned _mem_avl_rotate_right(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry) {
+    avl_link_pt link = ops->link(pool_mgr, entry);
+    unsigned pivot = link->left;
+    avl_link_pt pivot_link = ops->link(pool_mgr, pivot);
+
+    link->left = pivot_link->right;
+    pivot_link->right = entry;
+    _mem_avl_update(ops, pool_mgr, entry);
+    _mem_avl_update(ops, pool_mgr, pivot);
+
+    return pivot;
+}
+
+static unsigned _mem_avl_balance(const avl_ops_t *ops, pool_mgr_pt pool_mgr, unsigned entry) {
+    avl_link_pt link = ops->link(pool_mgr, entry);
+    unsigned hl = _mem_avl_height(ops, pool_mgr, link->left);
+    unsigned hr = _mem_avl_height(ops, pool_mgr, link->right);
+
+    if (hl > hr + 1) {
+        avl_link_pt left = ops->link(pool_mgr, link->left);
+        if (_mem_avl_height(ops, pool_mgr, left->right) > _mem_avl_height(ops, pool_mgr, left->left)) {
+            link->left = _mem_avl_rotate_left(ops, pool_mgr, link->left);
+        }
+        return _mem_avl_rotate_right(ops, pool_mgr, entry);
+    }
+    if (hr > hl + 1) {
+        avl_link_pt right = ops->link(pool_mgr, link->right);
+        if (_mem_avl_height(ops, pool_mgr, right->left) > _mem_avl_height(ops, pool_mgr, right->right)) {
+            link->right = _mem_avl_rotate_right(ops, pool_mgr, link->right);
+        }
+        return _mem_avl_rotate_left(ops, pool_mgr, entry);
+    }
+
+    _mem_avl_update(ops, pool_mgr, entry);
+    return entry;
+}
+
+// insert an entry (a leaf: no links, height 1) whose key is key into the
+// tree at root, and return the new root
+static unsigned _mem_avl_insert(const avl_ops_t *ops,
+                                pool_mgr_pt pool_mgr,
+                                unsigned root,
+                                unsigned entry,
+                                const void *key) {
+    if (root == MEM_AVL_NIL) {
+        return entry;
+    }
+
+    avl_link_pt link = ops->link(pool_mgr, root);
+    if (ops->cmp(pool_mgr, key, root) < 0) {
+        link->left = _mem_avl_insert(ops, pool_mgr, link->left, entry, key);
+    } else {
+        link->right = _mem_avl_insert(ops, pool_mgr, link->right, entry, key);
+    }
+
+    return _mem_avl_balance(ops, pool_mgr, root);
+}
+
+// remove the entry whose key is key, if any, from the tree at root, and
+// return the new root; the entry is returned in removed
+static unsigned _mem_avl_remove(const avl_ops_t *ops,
+                                pool_mgr_pt pool_mgr,
+                                unsigned root,
+                                const void *key,
+                                unsigned *removed) {
+    if (root == MEM_AVL_NIL) {
+        return MEM_AVL_NIL;
+    }
+
+    avl_link_pt link = ops->link(pool_mgr, root);
+    int cmp = ops->cmp(pool_mgr, key, root);
+
+    if (cmp < 0) {
+        link->left = _mem_avl_remove(ops, pool_mgr, link->left, key, removed);
+    } else if (cmp > 0) {
+        link->right = _mem_avl_remove(ops, pool_mgr, link->right, key, removed);
+    } else {
+        *removed = root;
+        if (link->left == MEM_AVL_NIL) {
+            return link->right;
+        }
+        if (link->right == MEM_AVL_NIL) {
+            return link->left;
+        }
+        // replace by the in-order successor
+        unsigned successor = MEM_AVL_NIL;
+        unsigned right = _mem_avl_remove_min(ops, pool_mgr, link->right, &successor);
+        avl_link_pt successor_link = ops->link(pool_mgr, successor);
+        successor_link->left = link->left;
+        successor_link->right = right;
+        root = successor;
+    }
+
+    return _mem_avl_balance(ops, pool_mgr, root);
+}
+
+static unsigned _mem_avl_remove_min(const avl_ops_t *ops,
+                                    pool_mgr_pt pool_mgr,
+                                    unsigned root,
+                                    unsigned *removed) {
+    avl_link_pt link = ops->link(pool_mgr, root);
+
+    if (link->left == MEM_AVL_NIL) {
+        *removed = root;
+        return link->right;
+    }
+
+    link->left = _mem_avl_remove_min(ops, pool_mgr, link->left, removed);
+
+    return _mem_avl_balance(ops, pool_mgr, root);
+}
+
+static void _mem_tlsf_mapping(size_t size, unsigned *fl, unsigned *sl) {
+    if (size < MEM_TLSF_SL_COUNT) {
+        *fl = 0;
+        *sl = (unsigned) size;
+        return;
+    }
+
+    unsigned log2 = 63 - __builtin_clzll((unsigned long long) size);
+
+    *fl = log2 - MEM_TLSF_SL_LOG2 + 1;
+    *sl = (unsigned) (size >> (log2 - MEM_TLSF_SL_LOG2)) - MEM_TLSF_SL_COUNT;
+}
+
+static void _mem_tlsf_insert(pool_mgr_pt pool_mgr, unsigned gap) {
+    tlsf_pt tlsf = pool_mgr->tlsf;
+    unsigned fl, sl;
+
+    _mem_tlsf_mapping(pool_mgr->gap_ix[gap].size, &fl, &sl);
+
+    // push on the head of the class list
+    unsigned head = tlsf->heads[fl][sl];
+    pool_mgr->gap_ix[gap].link.left = head;
+    pool_mgr->gap_ix[gap].link.right = MEM_GAP_IX_NIL;
+    if (head != MEM_GAP_IX_NIL) {
+        pool_mgr->gap_ix[head].link.right = gap;
+    }
+    tlsf->heads[fl][sl] = gap;
+
+    tlsf->sl_bitmap[fl] |= 1u << sl;
+    tlsf->fl_bitmap |= 1ull << fl;
+}
+
+static void _mem_tlsf_remove(pool_mgr_pt pool_mgr, unsigned gap) {
+    tlsf_pt tlsf = pool_mgr->tlsf;
+    unsigned next = pool_mgr->gap_ix[gap].link.left;
+    unsigned prev = pool_mgr->gap_ix[gap].link.right;
+    unsigned fl, sl;
+
+    _mem_tlsf_mapping(pool_mgr->gap_ix[gap].size, &fl, &sl);
+
+    if (prev != MEM_GAP_IX_NIL) {
+        pool_mgr->gap_ix[prev].link.left = next;
+    } else {
+        tlsf->heads[fl][sl] = next;
+    }
+    if (next != MEM_GAP_IX_NIL) {
+        pool_mgr->gap_ix[next].link.right = prev;
+    }
+
+    // clear the bits of a class that became empty
+    if (tlsf->heads[fl][sl] == MEM_GAP_IX_NIL) {
+        tlsf->sl_bitmap[fl] &= ~(1u << sl);
+        if (tlsf->sl_bitmap[fl] == 0) {
+            tlsf->fl_bitmap &= ~(1ull << fl);
+        }
+    }
+}
+
+// good fit: round the size up to the next class boundary, so that any
+// gap in the first non-empty class at or above it is large enough
+static unsigned _mem_tlsf_find(pool_mgr_pt pool_mgr, size_t size) {
+    tlsf_pt tlsf = pool_mgr->tlsf;
+    size_t rounded = size;
+    unsigned fl, sl;
+
+    if (size >= MEM_TLSF_SL_COUNT) {
+        unsigned log2 = 63 - __builtin_clzll((unsigned long long) size);
+        rounded += ((size_t) 1 << (log2 - MEM_TLSF_SL_LOG2)) - 1;
+    }
+
+    if (rounded >= size) {
+        _mem_tlsf_mapping(rounded, &fl, &sl);
+
+        unsigned sl_map = tlsf->sl_bitmap[fl] & (~0u << sl);
+        if (sl_map == 0) {
+            unsigned long long fl_map = fl + 1 < MEM_TLSF_FL_COUNT ?
+                                        tlsf->fl_bitmap & (~0ull << (fl + 1)) : 0;
+            if (fl_map != 0) {
+                fl = (unsigned) __builtin_ctzll(fl_map);
+                sl_map = tlsf->sl_bitmap[fl];
+            }
+        }
+        if (sl_map != 0) {
+            return tlsf->heads[fl][__builtin_ctz(sl_map)];
+        }
+    }
+
+    // last resort, still constant time: the head of the request's own class
+    _mem_tlsf_mapping(size, &fl, &sl);
+    unsigned head = tlsf->heads[fl][sl];
+    if (head != MEM_GAP_IX_NIL && pool_mgr->gap_ix[head].size >= size) {
+        return head;
+    }
+
+    return MEM_GAP_IX_NIL;
+}
+
+static alloc_status _mem_buddy_init(pool_mgr_pt pool_mgr) {
+    buddy_pt buddy = (buddy_pt) calloc(1, sizeof(buddy_t));
+    if (buddy == NULL) {
+        perror("_mem_buddy_init");
+        return ALLOC_FAIL;
+    }
+    buddy->arena = pool_mgr->pool.total_size & ~(((size_t) 1 << MEM_BUDDY_MIN_LOG2) - 1);
+
+    // lay out a free map for each order that fits in the pool
+    size_t words = 0;
+    while (buddy->orders < MEM_BUDDY_ORDER_COUNT
+           && (buddy->arena >> (MEM_BUDDY_MIN_LOG2 + buddy->orders)) > 0) {
+        buddy->map_base[buddy->orders] = words;
+        words += ((buddy->arena >> (MEM_BUDDY_MIN_LOG2 + buddy->orders)) + 63) / 64;
+        buddy->orders++;
+    }
+    buddy->free_map = (unsigned long long *) calloc(words > 0 ? words : 1, sizeof(unsigned long long));
+    if (buddy->free_map == NULL) {
+        perror("_mem_buddy_init");
+        free(buddy);
+        return ALLOC_FAIL;
+    }
+    pool_mgr->buddy = buddy;
+
+    // carve the pool into the largest blocks that fit, in decreasing size
+    size_t offset = 0;
+    for (unsigned order = buddy->orders; order > 0; --order) {
+        size_t size = (size_t) 1 << (MEM_BUDDY_MIN_LOG2 + order - 1);
+        if (buddy->arena & size) {
+            _mem_buddy_push(pool_mgr, offset, order - 1);
+            offset += size;
+        }
+    }
+
+    // the tail too short for a block is a gap that is never used
+    if (pool_mgr->pool.total_size > buddy->arena) {
+        pool_mgr->pool.num_gaps++;
+    }
+
+    return ALLOC_OK;
+}
+
+static void _mem_buddy_release(pool_mgr_pt pool_mgr) {
+    if (pool_mgr->buddy != NULL) {
+        free(pool_mgr->buddy->free_map);
+        free(pool_mgr->buddy);
+        pool_mgr->buddy = NULL;
+    }
+}
+
+// the smallest order whose blocks hold size bytes
+static unsigned _mem_buddy_order(size_t size) {
+    if (size <= ((size_t) 1 << MEM_BUDDY_MIN_LOG2)) {
+        return 0;
+    }
+
+    return (unsigned) (64 - __builtin_clzll((unsigned long long) (size - 1))) - MEM_BUDDY_MIN_LOG2;
+}
+
+static int _mem_buddy_is_free(pool_mgr_pt pool_mgr, size_t offset, unsigned order) {
+    buddy_pt buddy = pool_mgr->buddy;
+    size_t index = offset >> (MEM_BUDDY_MIN_LOG2 + order);
+
+    return (buddy->free_map[buddy->map_base[order] + index / 64] >> (index % 64)) & 1;
+}
+
+static void _mem_buddy_push(pool_mgr_pt pool_mgr, size_t offset, unsigned order) {
+    buddy_pt buddy = pool_mgr->buddy;
+    buddy_block_pt block = (buddy_block_pt) (pool_mgr->pool.mem + offset);
+    size_t index = offset >> (MEM_BUDDY_MIN_LOG2 + order);
+
+    block->next = buddy->heads[order];
+    block->prev = NULL;
+    if (block->next != NULL) {
+        block->next->prev = block;
+    }
+    buddy->heads[order] = block;
+
+    buddy->order_bitmap |= 1ull << order;
+    buddy->free_map[buddy->map_base[order] + index / 64] |= 1ull << (index % 64);
+
+    // update metadata (num_gaps)
+    pool_mgr->pool.num_gaps++;
+}
+
+static void _mem_buddy_unlink(pool_mgr_pt pool_mgr, size_t offset, unsigned order) {
+    buddy_pt buddy = pool_mgr->buddy;
+    buddy_block_pt block = (buddy_block_pt) (pool_mgr->pool.mem + offset);
+    size_t index = offset >> (MEM_BUDDY_MIN_LOG2 + order);
+
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        buddy->heads[order] = block->next;
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    }
+
+    if (buddy->heads[order] == NULL) {
+        buddy->order_bitmap &= ~(1ull << order);
+    }
+    buddy->free_map[buddy->map_base[order] + index / 64] &= ~(1ull << (index % 64));
+
+    // update metadata (num_gaps)
+    pool_mgr->pool.num_gaps--;
+}
+
+// take a block of the first non-empty order at or above the requested
+// one, and split it down, returning the upper halves to the free lists
+static char *_mem_buddy_alloc(pool_mgr_pt pool_mgr, unsigned order) {
+    buddy_pt buddy = pool_mgr->buddy;
+
+    if (order >= buddy->orders) {
+        return NULL;
+    }
+    unsigned long long orders = buddy->order_bitmap & (~0ull << order);
+    if (orders == 0) {
+        return NULL;
+    }
+
+    unsigned found = (unsigned) __builtin_ctzll(orders);
+    size_t offset = (size_t) ((char *) buddy->heads[found] - pool_mgr->pool.mem);
+    _mem_buddy_unlink(pool_mgr, offset, found);
+    while (found > order) {
+        --found;
+        _mem_buddy_push(pool_mgr, offset + ((size_t) 1 << (MEM_BUDDY_MIN_LOG2 + found)), found);
+    }
+
+    return pool_mgr->pool.mem + offset;
+}
+
+// merge the block with its buddy (offset ^ size) for as long as the
+// buddy is a whole free block and the merged one lies within the pool
+static void _mem_buddy_free(pool_mgr_pt pool_mgr, size_t offset, unsigned order) {
+    buddy_pt buddy = pool_mgr->buddy;
+
+    while (order + 1 < buddy->orders) {
+        size_t size = (size_t) 1 << (MEM_BUDDY_MIN_LOG2 + order);
+        size_t merged = offset & ~(2 * size - 1);
+
+        if (merged + 2 * size > buddy->arena
+            || !_mem_buddy_is_free(pool_mgr, offset ^ size, order)) {
+            break;
+        }
+        _mem_buddy_unlink(pool_mgr, offset ^ size, order);
+        offset = merged;
+        ++order;
+    }
+
+    _mem_buddy_push(pool_mgr, offset, order);
+}
+
+// the size of the free block at offset, if any, else 0
+static size_t _mem_buddy_gap_size(pool_mgr_pt pool_mgr, size_t offset) {
+    for (unsigned order = pool_mgr->buddy->orders; order > 0; --order) {
+        size_t size = (size_t) 1 << (MEM_BUDDY_MIN_LOG2 + order - 1);
+        if ((offset & (size - 1)) == 0 && offset + size <= pool_mgr->buddy->arena
+            && _mem_buddy_is_free(pool_mgr, offset, order - 1)) {
+            return size;
+        }
+    }
+
+    return 0;
+}
+
+static alloc_status _mem_bitmap_init(pool_mgr_pt pool_mgr) {
+    size_t granules = pool_mgr->pool.total_size >> MEM_BITMAP_GRANULE_LOG2;
+    size_t words = (granules + 63) / 64;
+
+    bitmap_pt bitmap = (bitmap_pt) calloc(1, sizeof(bitmap_t) + 2 * words * sizeof(unsigned long long));
+    if (bitmap == NULL) {
+        perror("_mem_bitmap_init");
+        return ALLOC_FAIL;
+    }
+    bitmap->granules = granules;
+    bitmap->words = words;
+    bitmap->ends = bitmap->map + words;
+    if (granules % 64 != 0) {
+        bitmap->map[words - 1] = ~0ull << (granules % 64);
+    }
+    bitmap->free_runs = granules > 0;
+    pool_mgr->bitmap = bitmap;
+
+    _mem_bitmap_count_gaps(pool_mgr);
+
+    return ALLOC_OK;
+}
+
+// granules outside the pool count as used
+static int _mem_bitmap_used(pool_mgr_pt pool_mgr, size_t granule) {
+    bitmap_pt bitmap = pool_mgr->bitmap;
+
+    if (granule >= bitmap->granules) {
+        return 1;
+    }
+
+    return (bitmap->map[granule / 64] >> (granule % 64)) & 1;
+}
+
+// first fit, a word at a time: full words are skipped, empty words add
+// 64 granules to the run, and the others are walked run by run with ctz
+static size_t _mem_bitmap_find(pool_mgr_pt pool_mgr, size_t count) {
+    bitmap_pt bitmap = pool_mgr->bitmap;
+    size_t first = 0;
+    size_t run = 0;
+
+    for (size_t word = 0; word < bitmap->words; ++word) {
+        unsigned long long used = bitmap->map[word];
+
+        if (used == ~0ull) {
+            run = 0;
+            continue;
+        }
+        if (used == 0) {
+            if (run == 0) {
+                first = word * 64;
+            }
+            run += 64;
+            if (run >= count) {
+                return first;
+            }
+            continue;
+        }
+
+        unsigned bit = 0;
+        while (bit < 64) {
+            unsigned long long rest = used >> bit;
+            if (rest & 1) {
+                // skip the used run (the bits shifted in read as free)
+                bit += (unsigned) __builtin_ctzll(~rest);
+                run = 0;
+            } else {
+                unsigned length = rest == 0 ? 64 - bit : (unsigned) __builtin_ctzll(rest);
+                if (run == 0) {
+                    first = word * 64 + bit;
+                }
+                run += length;
+                if (run >= count) {
+                    return first;
+                }
+                bit += length;
+            }
+        }
+    }
+
+    return (size_t) -1;
+}
+
+// take the first run of enough free granules for size bytes, and mark
+// them used, or NULL if there is none
+static char *_mem_bitmap_alloc(pool_mgr_pt pool_mgr, size_t size) {
+    size_t granule = (size_t) 1 << MEM_BITMAP_GRANULE_LOG2;
+
+    if (size > pool_mgr->pool.total_size) {
+        return NULL;
+    }
+    size_t count = (size + granule - 1) >> MEM_BITMAP_GRANULE_LOG2;
+    size_t first = _mem_bitmap_find(pool_mgr, count);
+    if (first == (size_t) -1) {
+        return NULL;
+    }
+    _mem_bitmap_mark(pool_mgr, first, count, 1);
+    pool_mgr->pool.num_allocs++;
+    pool_mgr->pool.alloc_size += count << MEM_BITMAP_GRANULE_LOG2;
+
+    return pool_mgr->pool.mem + (first << MEM_BITMAP_GRANULE_LOG2);
+}
+
+// clear the bits of the allocation at mem, after making sure it starts
+// one: its granule is used, and the one before it is free or ends another
+// note: it merges with free neighbors by itself
+static alloc_status _mem_bitmap_free(pool_mgr_pt pool_mgr, char *mem) {
+    bitmap_pt bitmap = pool_mgr->bitmap;
+    size_t offset = (size_t) (mem - pool_mgr->pool.mem);
+
+    if (mem < pool_mgr->pool.mem || offset % ((size_t) 1 << MEM_BITMAP_GRANULE_LOG2) != 0) {
+        return ALLOC_FAIL;
+    }
+    size_t first = offset >> MEM_BITMAP_GRANULE_LOG2;
+    if (first >= bitmap->granules || !_mem_bitmap_used(pool_mgr, first)
+        || (first > 0 && _mem_bitmap_used(pool_mgr, first - 1)
+            && !((bitmap->ends[(first - 1) / 64] >> ((first - 1) % 64)) & 1))) {
+        return ALLOC_FAIL;
+    }
+    size_t count = _mem_bitmap_run(pool_mgr, first);
+    _mem_bitmap_mark(pool_mgr, first, count, 0);
+    pool_mgr->pool.num_allocs--;
+    pool_mgr->pool.alloc_size -= count << MEM_BITMAP_GRANULE_LOG2;
+
+    return ALLOC_OK;
+}
+
+// the number of granules of the allocation starting at granule, up to
+// the first end bit at or after it
+static size_t _mem_bitmap_run(pool_mgr_pt pool_mgr, size_t granule) {
+    bitmap_pt bitmap = pool_mgr->bitmap;
+    size_t word = granule / 64;
+    unsigned long long ends = bitmap->ends[word] & (~0ull << (granule % 64));
+
+    while (ends == 0) {
+        ends = bitmap->ends[++word];
+    }
+
+    return word * 64 + (size_t) __builtin_ctzll(ends) - granule + 1;
+}
+
+// the first used granule at or after granule, or the number of granules
+static size_t _mem_bitmap_next_used(pool_mgr_pt pool_mgr, size_t granule) {
+    bitmap_pt bitmap = pool_mgr->bitmap;
+    size_t word = granule / 64;
+    unsigned long long used = bitmap->map[word] & (~0ull << (granule % 64));
+
+    while (used == 0 && ++word < bitmap->words) {
+        used = bitmap->map[word];
+    }
+    if (used == 0) {
+        return bitmap->granules;
+    }
+    granule = word * 64 + (size_t) __builtin_ctzll(used);
+
+    return granule < bitmap->granules ? granule : bitmap->granules;
+}
+
+// set or clear the bits of a run of granules, a word at a time, and
+// update the count of free runs from its neighbors
+static void _mem_bitmap_mark(pool_mgr_pt pool_mgr, size_t first, size_t count, int used) {
+    bitmap_pt bitmap = pool_mgr->bitmap;
+    int left_free = first > 0 && !_mem_bitmap_used(pool_mgr, first - 1);
+    int right_free = !_mem_bitmap_used(pool_mgr, first + count);
+
+    for (size_t granule = first; granule < first + count;) {
+        size_t bit = granule % 64;
+        size_t bits = 64 - bit < first + count - granule ? 64 - bit : first + count - granule;
+        unsigned long long mask = (bits == 64 ? ~0ull : ((1ull << bits) - 1)) << bit;
+
+        if (used) {
+            bitmap->map[granule / 64] |= mask;
+        } else {
+            bitmap->map[granule / 64] &= ~mask;
+        }
+        granule += bits;
+    }
+    // and the end bit of its last granule
+    size_t last = first + count - 1;
+    if (used) {
+        bitmap->ends[last / 64] |= 1ull << (last % 64);
+    } else {
+        bitmap->ends[last / 64] &= ~(1ull << (last % 64));
+    }
+
+    // taking a run splits, shortens or removes a free run; giving one
+    // back joins, extends or adds one
+    if (used) {
+        bitmap->free_runs += left_free && right_free;
+        bitmap->free_runs -= !left_free && !right_free;
+    } else {
+        bitmap->free_runs -= left_free && right_free;
+        bitmap->free_runs += !left_free && !right_free;
+    }
+
+    _mem_bitmap_count_gaps(pool_mgr);
+}
+
+// the gaps are the free runs, and the tail too short for a granule,
+// unless it extends the last free run
+static void _mem_bitmap_count_gaps(pool_mgr_pt pool_mgr) {
+    bitmap_pt bitmap = pool_mgr->bitmap;
+    size_t tail = pool_mgr->pool.total_size - (bitmap->granules << MEM_BITMAP_GRANULE_LOG2);
+
+    pool_mgr->pool.num_gaps = bitmap->free_runs
+                              + (tail > 0 && (bitmap->granules == 0
+                                              || _mem_bitmap_used(pool_mgr, bitmap->granules - 1)));
+}
+
+// allocate a region of region_size bytes, or size if larger, and append
+// it as a gap node to the node list
+static alloc_status _mem_add_region(pool_mgr_pt pool_mgr, size_t size) {
+    regions_pt regions = pool_mgr->regions;
+
+    size = size > regions->region_size ? size : regions->region_size;
+    region_pt region = (region_pt) malloc(sizeof(region_t) + size);
+    if (region == NULL) {
+        perror("_mem_add_region");
+        return ALLOC_FAIL;
+    }
+    // note: the node heap has a free node (see mem_new_alloc); keep one
+    // more for the remainder of the gap, once split
+    unsigned node = _mem_get_node(pool_mgr);
+    if (_mem_resize_node_heap(pool_mgr) != ALLOC_OK) {
+        _mem_put_node(pool_mgr, node);
+        free(region);
+        return ALLOC_FAIL;
+    }
+    alloc_pt record = _mem_node_record(pool_mgr, node);
+    record->mem = (char *) (region + 1);
+    record->size = size;
+    if (_mem_add_to_gap_ix(pool_mgr, size, node) != ALLOC_OK) {
+        _mem_put_node(pool_mgr, node);
+        free(region);
+        return ALLOC_FAIL;
+    }
+
+    // append it to the node list
+    _mem_node_link(pool_mgr, pool_mgr->tail)->next = node;
+    _mem_node_link(pool_mgr, node)->prev = pool_mgr->tail;
+    pool_mgr->tail = node;
+
+    // and to the regions
+    region->size = size;
+    region->prev = NULL;
+    region->next = regions->head;
+    if (regions->head != NULL) {
+        regions->head->prev = region;
+    }
+    regions->head = region;
+    regions->count++;
+    pool_mgr->pool.total_size += size;
+    pool_mgr->pool.committed_size += size;
+    pool_mgr->pool.reserved_size += size;
+
+    return ALLOC_OK;
+}
+
+// if a gap is a whole added region, then keep it, if it is the largest
+// empty one, and free the other empty one, if any
+// note: a region is headed by its region_t, so neither the first region
+// nor another one is ever next to it in memory
+static alloc_status _mem_release_region(pool_mgr_pt pool_mgr, unsigned node) {
+    regions_pt regions = pool_mgr->regions;
+    alloc_pt record = _mem_node_record(pool_mgr, node);
+    link_pt link = _mem_node_link(pool_mgr, node);
+
+    if (record->mem == pool_mgr->pool.mem
+        || (link->prev != MEM_NODE_NIL
+            && _mem_node_record(pool_mgr, link->prev)->mem + _mem_node_record(pool_mgr, link->prev)->size
+               == record->mem)
+        || (link->next != MEM_NODE_NIL
+            && record->mem + record->size == _mem_node_record(pool_mgr, link->next)->mem)) {
+        return ALLOC_OK;
+    }
+    if (regions->spare == MEM_NODE_NIL) {
+        regions->spare = node;
+        return ALLOC_OK;
+    }
+    if (_mem_node_record(pool_mgr, regions->spare)->size < record->size) {
+        unsigned kept = node;
+        node = regions->spare;
+        regions->spare = kept;
+        record = _mem_node_record(pool_mgr, node);
+        link = _mem_node_link(pool_mgr, node);
+    }
+
+    // take the gap out of the gap index and of the node list
+    if (_mem_remove_from_gap_ix(pool_mgr, record->size, node) != ALLOC_OK) {
+        return ALLOC_FAIL;
+    }
+    _mem_node_link(pool_mgr, link->prev)->next = link->next;
+    if (link->next != MEM_NODE_NIL) {
+        _mem_node_link(pool_mgr, link->next)->prev = link->prev;
+    }
+    if (pool_mgr->tail == node) {
+        pool_mgr->tail = link->prev;
+    }
+
+    // and the region out of the regions
+    region_pt region = (region_pt) record->mem - 1;
+    if (region->prev != NULL) {
+        region->prev->next = region->next;
+    } else {
+        regions->head = region->next;
+    }
+    if (region->next != NULL) {
+        region->next->prev = region->prev;
+    }
+    regions->count--;
+    pool_mgr->pool.total_size -= region->size;
+    pool_mgr->pool.committed_size -= region->size;
+    pool_mgr->pool.reserved_size -= region->size;
+
+    _mem_put_node(pool_mgr, node);
+    free(region);
+
+    return ALLOC_OK;
+}
+
+
+// reserve the address space of a pool, inaccessible and not counted
+// against memory, and commit none of it yet
+static alloc_status _mem_reserve(pool_mgr_pt pool_mgr, size_t size, size_t reserve) {
+    reserve_pt res = (reserve_pt) calloc(1, sizeof(reserve_t));
+    if (res == NULL) {
+        perror("_mem_reserve");
+        return ALLOC_FAIL;
+    }
+    res->page_size = (size_t) sysconf(_SC_PAGESIZE);
+    res->reserve = (reserve + res->page_size - 1) / res->page_size * res->page_size;
+    res->size = size;
+    res->limit = res->reserve;
+    res->committed = 0;
+
+    void *mem = mmap(NULL, res->reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("_mem_reserve");
+        free(res);
+        return ALLOC_FAIL;
+    }
+    pool_mgr->pool.mem = (char *) mem;
+    pool_mgr->pool.backing = MMAP_BACKED;
+    pool_mgr->reserve = res;
+
+    return ALLOC_OK;
+}
+
+// map the memory of a pool on huge pages: explicit ones, if the system has
+// enough set aside, or else transparent ones, for which it is aligned
+static alloc_status _mem_map_huge(pool_mgr_pt pool_mgr, size_t size) {
+    reserve_pt res = (reserve_pt) calloc(1, sizeof(reserve_t));
+    if (res == NULL) {
+        perror("_mem_map_huge");
+        return ALLOC_FAIL;
+    }
+    res->page_size = MEM_HUGE_PAGE_SIZE;
+    res->reserve = (size + MEM_HUGE_PAGE_SIZE - 1) / MEM_HUGE_PAGE_SIZE * MEM_HUGE_PAGE_SIZE;
+    res->size = size;
+    res->limit = size;
+    res->committed = res->reserve;
+
+    void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    mem = mmap(NULL, res->reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    pool_mgr->pool.backing = HUGETLB_BACKED;
+#endif
+    if (mem == MAP_FAILED) {
+        // map a huge page more than needed, and trim it to be aligned
+        char *raw = (char *) mmap(NULL, res->reserve + MEM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            perror("_mem_map_huge");
+            free(res);
+            return ALLOC_FAIL;
+        }
+        char *aligned = (char *) (((uintptr_t) raw + MEM_HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (MEM_HUGE_PAGE_SIZE - 1));
+        if (aligned > raw) {
+            munmap(raw, (size_t) (aligned - raw));
+        }
+        if (aligned < raw + MEM_HUGE_PAGE_SIZE) {
+            munmap(aligned + res->reserve, (size_t) (raw + MEM_HUGE_PAGE_SIZE - aligned));
+        }
+        mem = aligned;
+        pool_mgr->pool.backing = MMAP_BACKED;
+#ifdef MADV_HUGEPAGE
+        if (madvise(mem, res->reserve, MADV_HUGEPAGE) == 0 && _mem_thp_enabled()) {
+            pool_mgr->pool.backing = THP_BACKED;
+        }
+#endif
+    }
+    pool_mgr->pool.mem = (char *) mem;
+    pool_mgr->reserve = res;
+
+    return ALLOC_OK;
+}
+
+// tell if transparent huge pages are enabled, if only on request
+static int _mem_thp_enabled() {
+    char mode[64] = "";
+
+    FILE *file = fopen(MEM_THP_ENABLED_PATH, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    if (fgets(mode, sizeof(mode), file) == NULL) {
+        mode[0] = '\0';
+    }
+    fclose(file);
+
+    return strstr(mode, "[always]") != NULL || strstr(mode, "[madvise]") != NULL;
+}
+
+// allocate the counts of the huge pages a HUGE_FIT pool spans, up to the
+// reservation for a reserved pool, all empty
+static alloc_status _mem_huge_init(pool_mgr_pt pool_mgr, size_t size) {
+    size_t extent = pool_mgr->reserve != NULL ? pool_mgr->reserve->limit : size;
+    uintptr_t base = (uintptr_t) pool_mgr->pool.mem & ~(uintptr_t) (MEM_HUGE_PAGE_SIZE - 1);
+    uintptr_t end = ((uintptr_t) pool_mgr->pool.mem + extent + MEM_HUGE_PAGE_SIZE - 1)
+                    & ~(uintptr_t) (MEM_HUGE_PAGE_SIZE - 1);
+    unsigned count = (unsigned) ((end - base) / MEM_HUGE_PAGE_SIZE);
+
+    unsigned words = (count + 63) / 64;
+
+    huge_pt huge = (huge_pt) calloc(1, sizeof(huge_t) + count * sizeof(size_t)
+                                       + words * sizeof(unsigned long long));
+    if (huge == NULL) {
+        perror("_mem_huge_init");
+        return ALLOC_FAIL;
+    }
+    huge->base = base;
+    huge->count = count;
+    huge->in_use = (unsigned long long *) (huge->used + count);
+    pool_mgr->huge = huge;
+
+    return ALLOC_OK;
+}
+
+// count an allocation in, or out of, the huge pages it overlaps, and mark
+// those it fills up or empties out
+// note: the regions of a growable pool are outside of them
+static void _mem_huge_update(pool_mgr_pt pool_mgr, const char *mem, size_t size, int allocated) {
+    huge_pt huge = pool_mgr->huge;
+    uintptr_t start = (uintptr_t) mem;
+    uintptr_t end = start + size;
+
+    if (start < huge->base || end > huge->base + (uintptr_t) huge->count * MEM_HUGE_PAGE_SIZE) {
+        return;
+    }
+    for (unsigned page = (unsigned) ((start - huge->base) / MEM_HUGE_PAGE_SIZE);
+         huge->base + (uintptr_t) page * MEM_HUGE_PAGE_SIZE < end; ++page) {
+        uintptr_t lo = huge->base + (uintptr_t) page * MEM_HUGE_PAGE_SIZE;
+        uintptr_t hi = lo + MEM_HUGE_PAGE_SIZE;
+        size_t overlap = (size_t) ((end < hi ? end : hi) - (start > lo ? start : lo));
+
+        if (allocated) {
+            huge->used[page] += overlap;
+        } else {
+            huge->used[page] -= overlap;
+        }
+        if (huge->used[page] > 0) {
+            huge->in_use[page / 64] |= 1ull << (page % 64);
+        } else {
+            huge->in_use[page / 64] &= ~(1ull << (page % 64));
+        }
+    }
+}
+
+// the first huge page in use at or after page, or the number of pages
+static unsigned _mem_huge_next_in_use(huge_pt huge, unsigned page) {
+    if (page >= huge->count) {
+        return huge->count;
+    }
+    unsigned word = page / 64;
+    unsigned long long in_use = huge->in_use[word] & (~0ull << (page % 64));
+
+    while (in_use == 0 && ++word < (huge->count + 63) / 64) {
+        in_use = huge->in_use[word];
+    }
+    if (in_use == 0) {
+        return huge->count;
+    }
+
+    return word * 64 + (unsigned) __builtin_ctzll(in_use);
+}
+
+// the lowest sufficient gap that starts and ends in huge pages in use, so
+// that they fill up before an empty one is touched, and the empty ones
+// stay empty (and decommitted); or else, and for a request of a huge page
+// or more, the lowest sufficient gap
+// note: a gap that reaches into an empty page skips the search past it
+static unsigned _mem_huge_find(pool_mgr_pt pool_mgr, size_t size) {
+    huge_pt huge = pool_mgr->huge;
+
+    if (size < MEM_HUGE_PAGE_SIZE) {
+        unsigned page = _mem_huge_next_in_use(huge, 0);
+        for (unsigned tries = 0; page < huge->count && tries < MEM_HUGE_MAX_TRIES; ++tries) {
+            unsigned gap = _mem_gap_find_next(pool_mgr, size,
+                                              (const char *) (huge->base + (uintptr_t) page * MEM_HUGE_PAGE_SIZE));
+            if (gap == MEM_GAP_IX_NIL) {
+                break;
+            }
+            uintptr_t start = (uintptr_t) _mem_gap_record(pool_mgr, gap)->mem;
+            if (start + size > huge->base + (uintptr_t) huge->count * MEM_HUGE_PAGE_SIZE) {
+                break;
+            }
+            unsigned first = (unsigned) ((start - huge->base) / MEM_HUGE_PAGE_SIZE);
+            unsigned last = (unsigned) ((start + size - 1 - huge->base) / MEM_HUGE_PAGE_SIZE);
+            if (huge->used[first] > 0 && huge->used[last] > 0) {
+                return gap;
+            }
+            page = _mem_huge_next_in_use(huge, (huge->used[first] > 0 ? last : first) + 1);
+        }
+    }
+
+    return _mem_gap_find_first(pool_mgr, size);
+}
+
+// commit the pages up to the end of an allocation, if it is in the
+// reserved range and past what is committed
+// note: the regions of a growable pool are outside of it
+static alloc_status _mem_commit(pool_mgr_pt pool_mgr, const char *mem, size_t size) {
+    reserve_pt reserve = pool_mgr->reserve;
+    uintptr_t start = (uintptr_t) pool_mgr->pool.mem;
+
+    if ((uintptr_t) mem < start || (uintptr_t) mem >= start + reserve->size) {
+        return ALLOC_OK;
+    }
+    size_t end = (size_t) ((uintptr_t) mem - start) + size;
+
+    // count the decommitted pages it reaches as committed again: the OS
+    // gives them back, zeroed, when they are touched
+    if (reserve->decommitted != NULL) {
+        size_t last = (end < reserve->committed ? end : reserve->committed) + reserve->page_size - 1;
+        for (size_t page = ((uintptr_t) mem - start) / reserve->page_size;
+             page < last / reserve->page_size; ++page) {
+            if (reserve->decommitted[page / 64] >> (page % 64) & 1) {
+                reserve->decommitted[page / 64] &= ~(1ull << (page % 64));
+                pool_mgr->pool.committed_size += reserve->page_size;
+            }
+        }
+    }
+
+    if (end <= reserve->committed) {
+        return ALLOC_OK;
+    }
+    end = (end + reserve->page_size - 1) / reserve->page_size * reserve->page_size;
+    if (mprotect(pool_mgr->pool.mem + reserve->committed, end - reserve->committed,
+                 PROT_READ | PROT_WRITE) != 0) {
+        perror("_mem_commit");
+        return ALLOC_FAIL;
+    }
+    pool_mgr->pool.committed_size += end - reserve->committed;
+    reserve->committed = end;
+
+    return ALLOC_OK;
+}
+
+// grow a reserved pool in place, by what the request lacks past the gap
+// at its end, if any, but at least doubling it, up to the reservation
+static alloc_status _mem_grow_reserve(pool_mgr_pt pool_mgr, size_t size) {
+    reserve_pt reserve = pool_mgr->reserve;
+    char *end = pool_mgr->pool.mem + reserve->size;
+
+    // the last node of the range
+    // note: the nodes of the regions of a growable pool may follow it
+    unsigned last = reserve->last;
+    alloc_pt last_record = _mem_node_record(pool_mgr, last);
+    link_pt last_link = _mem_node_link(pool_mgr, last);
+
+    // work out the new size, by whole pages
+    size_t tail = last_link->allocated ? 0 : last_record->size;
+    size_t lack = size > tail ? size - tail : 0;
+    size_t grow = lack > reserve->size ? lack : reserve->size;
+    if (grow > reserve->limit - reserve->size) {
+        grow = reserve->limit - reserve->size;
+    } else {
+        size_t grown = (reserve->size + grow + reserve->page_size - 1) / reserve->page_size * reserve->page_size;
+        grow = (grown < reserve->limit ? grown : reserve->limit) - reserve->size;
+    }
+    if (grow == 0 || grow < lack) {
+        return ALLOC_FAIL;
+    }
+
+    // if the last node is a gap, then extend it
+    if (!last_link->allocated) {
+        if (_mem_remove_from_gap_ix(pool_mgr, last_record->size, last) != ALLOC_OK) {
+            return ALLOC_FAIL;
+        }
+        last_record->size += grow;
+        if (_mem_add_to_gap_ix(pool_mgr, last_record->size, last) != ALLOC_OK) {
+            return ALLOC_FAIL;
+        }
+    } else {
+        // otherwise, add a gap node after it
+        // note: the node heap has a free node (see mem_new_alloc); keep one
+        // more for the remainder of the gap, once split
+        unsigned node = _mem_get_node(pool_mgr);
+        if (_mem_resize_node_heap(pool_mgr) != ALLOC_OK) {
+            _mem_put_node(pool_mgr, node);
+            return ALLOC_FAIL;
+        }
+        alloc_pt record = _mem_node_record(pool_mgr, node);
+        link_pt link = _mem_node_link(pool_mgr, node);
+        record->mem = end;
+        record->size = grow;
+        if (_mem_add_to_gap_ix(pool_mgr, grow, node) != ALLOC_OK) {
+            _mem_put_node(pool_mgr, node);
+            return ALLOC_FAIL;
+        }
+        link->prev = last;
+        link->next = last_link->next;
+        if (last_link->next != MEM_NODE_NIL) {
+            _mem_node_link(pool_mgr, last_link->next)->prev = node;
+        }
+        last_link->next = node;
+        if (pool_mgr->tail == last) {
+            pool_mgr->tail = node;
+        }
+        reserve->last = node;
+    }
+
+    reserve->size += grow;
+    pool_mgr->pool.total_size += grow;
+
+    return ALLOC_OK;
+}
+
+// free the memory of a pool, or give its address space back
+static void _mem_free_pool_mem(pool_mgr_pt pool_mgr) {
+    if (pool_mgr->reserve != NULL) {
+        munmap(pool_mgr->pool.mem, pool_mgr->reserve->reserve);
+        free(pool_mgr->reserve->decommitted);
+        free(pool_mgr->reserve);
+        pool_mgr->reserve = NULL;
+    } else {
+        free(pool_mgr->pool.mem);
+    }
+}
+
+// give the free committed pages of the gaps in the reserved range back to
+// the OS, whole gaps at a time, from the end of the range (the least used
+// by most policies), until no more than the retained bytes are left
+static void _mem_decommit_gaps(pool_mgr_pt pool_mgr) {
+    reserve_pt reserve = pool_mgr->reserve;
+    size_t free_bytes = _mem_free_committed(pool_mgr);
+
+    reserve->freed = 0;
+    for (unsigned node = reserve->last; node != MEM_NODE_NIL && free_bytes > reserve->retain;
+         node = _mem_node_link(pool_mgr, node)->prev) {
+        if (!_mem_node_link(pool_mgr, node)->allocated) {
+            free_bytes -= _mem_decommit_pages(pool_mgr, _mem_node_record(pool_mgr, node));
+        }
+    }
+}
+
+// decommit the committed whole pages of a gap, and return their bytes
+static size_t _mem_decommit_pages(pool_mgr_pt pool_mgr, alloc_pt gap) {
+    reserve_pt reserve = pool_mgr->reserve;
+    unsigned long long *map = reserve->decommitted;
+    size_t offset = (size_t) (gap->mem - pool_mgr->pool.mem);
+    size_t end = offset + gap->size < reserve->committed ? offset + gap->size : reserve->committed;
+    size_t page = (offset + reserve->page_size - 1) / reserve->page_size;
+    size_t last = end / reserve->page_size;
+
+    size_t bytes = 0;
+    while (page < last) {
+        // skip whole words of decommitted pages
+        if (page % 64 == 0 && last - page >= 64 && map[page / 64] == ~0ull) {
+            page += 64;
+            continue;
+        }
+        if (map[page / 64] >> (page % 64) & 1) {
+            page++;
+            continue;
+        }
+        // find the run of committed pages from here
+        size_t run = page;
+        while (run < last && !(map[run / 64] >> (run % 64) & 1)) {
+            run++;
+        }
+        if (madvise(pool_mgr->pool.mem + page * reserve->page_size,
+                    (run - page) * reserve->page_size, MADV_DONTNEED) != 0) {
+            perror("_mem_decommit_pages");
+            return bytes;
+        }
+        for (size_t p = page; p < run; ++p) {
+            map[p / 64] |= 1ull << (p % 64);
+        }
+        pool_mgr->pool.committed_size -= (run - page) * reserve->page_size;
+        bytes += (run - page) * reserve->page_size;
+        page = run;
+    }
+
+    return bytes;
+}
+
+// the number of whole pages of a gap, if it is in the reserved range
+// note: the regions of a growable pool are outside of it; the limit is
+// checked, as a gap added when the range grows is counted before size is
+static size_t _mem_gap_pages(pool_mgr_pt pool_mgr, const char *mem, size_t size) {
+    reserve_pt reserve = pool_mgr->reserve;
+    uintptr_t start = (uintptr_t) pool_mgr->pool.mem;
+
+    if ((uintptr_t) mem < start || (uintptr_t) mem >= start + reserve->limit) {
+        return 0;
+    }
+    size_t offset = (size_t) ((uintptr_t) mem - start);
+    size_t first = (offset + reserve->page_size - 1) / reserve->page_size;
+    size_t last = (offset + size) / reserve->page_size;
+
+    return last > first ? last - first : 0;
+}
+
+// the bytes of the whole pages in the gaps of the range, less those
+// decommitted and those never committed, which are all in gaps
+static size_t _mem_free_committed(pool_mgr_pt pool_mgr) {
+    reserve_pt reserve = pool_mgr->reserve;
+    size_t regions = pool_mgr->pool.total_size - reserve->size;
+    size_t decommitted = reserve->committed - (pool_mgr->pool.committed_size - regions);
+    size_t pages = reserve->size / reserve->page_size;
+    size_t committed = reserve->committed / reserve->page_size;
+    size_t uncommitted = pages > committed ? pages - committed : 0;
+
+    return (reserve->gap_pages - uncommitted) * reserve->page_size - decommitted;
+}
+
+// convert an allocation node, no longer in the address index, to a gap
+// node, merged with the gap nodes next to it
+static alloc_status _mem_merge_gap(pool_mgr_pt pool_mgr, unsigned node_ix) {
+    alloc_pt node = _mem_node_record(pool_mgr, node_ix);
+    link_pt link = _mem_node_link(pool_mgr, node_ix);
+    size_t freed = node->size;
+
+    // uncount it from its huge pages, if HUGE_FIT
+    if (pool_mgr->huge != NULL) {
+        _mem_huge_update(pool_mgr, node->mem, node->size, 0);
+    }
+
+    // convert to gap node
+    link->allocated = 0;
+
+    // if the next node in the list is also a gap, merge into node-to-delete
+    // note: in a growable pool, the next node may start another region
+    unsigned next_ix = link->next;
+    if (next_ix != MEM_NODE_NIL && !_mem_node_link(pool_mgr, next_ix)->allocated
+        && node->mem + node->size == _mem_node_record(pool_mgr, next_ix)->mem) {
+        alloc_pt next = _mem_node_record(pool_mgr, next_ix);
+        link_pt next_link = _mem_node_link(pool_mgr, next_ix);
+        //   remove the next node from gap index
+        //   check success
+        if (_mem_remove_from_gap_ix(pool_mgr, next->size, next_ix) != ALLOC_OK) {
+            return ALLOC_FAIL;
+        }
+        //   add the size to the node-to-delete
+        node->size += next->size;
+        //   update linked list:
+        if (next_link->next != MEM_NODE_NIL) {
+            _mem_node_link(pool_mgr, next_link->next)->prev = node_ix;
+        }
+        link->next = next_link->next;
+        if (pool_mgr->tail == next_ix) {
+            pool_mgr->tail = node_ix;
+        }
+        if (pool_mgr->reserve != NULL && pool_mgr->reserve->last == next_ix) {
+            pool_mgr->reserve->last = node_ix;
+        }
+        //   push the node as unused (updates used_nodes)
+        _mem_put_node(pool_mgr, next_ix);
+    }
+
+    // this merged node-to-delete might need to be added to the gap index
+    // but one more thing to check...
+    // if the previous node in the list is also a gap, merge into previous!
+    unsigned prev_ix = link->prev;
+    if (prev_ix != MEM_NODE_NIL && !_mem_node_link(pool_mgr, prev_ix)->allocated
+        && _mem_node_record(pool_mgr, prev_ix)->mem + _mem_node_record(pool_mgr, prev_ix)->size == node->mem) {
+        alloc_pt prev = _mem_node_record(pool_mgr, prev_ix);
+        link_pt prev_link = _mem_node_link(pool_mgr, prev_ix);
+        //   remove the previous node from gap index
+        //   check success
+        if (_mem_remove_from_gap_ix(pool_mgr, prev->size, prev_ix) != ALLOC_OK) {
+            return ALLOC_FAIL;
+        }
+        //   add the size of node-to-delete to the previous
+        prev->size += node->size;
+        //   update linked list
+        if (link->next != MEM_NODE_NIL) {
+            _mem_node_link(pool_mgr, link->next)->prev = prev_ix;
+        }
+        prev_link->next = link->next;
+        if (pool_mgr->tail == node_ix) {
+            pool_mgr->tail = prev_ix;
+        }
+        if (pool_mgr->reserve != NULL && pool_mgr->reserve->last == node_ix) {
+            pool_mgr->reserve->last = prev_ix;
+        }
+        //   push node-to-delete as unused (updates used_nodes)
+        _mem_put_node(pool_mgr, node_ix);
+        //   change the node to add to the previous node!
+        node = prev;
+        node_ix = prev_ix;
+    }
+
+    // add the resulting node to the gap index
+    // check success
+    if (_mem_add_to_gap_ix(pool_mgr, node->size, node_ix) != ALLOC_OK) {
+        return ALLOC_FAIL;
+    }
+
+    // if it is a whole added region, then keep it or free it
+    if (pool_mgr->regions != NULL && _mem_release_region(pool_mgr, node_ix) != ALLOC_OK) {
+        return ALLOC_FAIL;
+    }
+
+    // if gaps are decommitted, then do it once more than the retained
+    // bytes have been freed since the last time, and are free and
+    // committed, so that memory freed and allocated again right away
+    // stays committed
+    reserve_pt reserve = pool_mgr->reserve;
+    if (reserve != NULL && reserve->decommitted != NULL) {
+        reserve->freed += freed;
+        if (reserve->freed > reserve->retain && _mem_free_committed(pool_mgr) > reserve->retain) {
+            _mem_decommit_gaps(pool_mgr);
+        }
+    }
+
+    return ALLOC_OK;
+}
+
+static unsigned _mem_quick_bin(size_t size) {
+    unsigned long long hash = (unsigned long long) size * 11400714819323198485ull;
+
+    return (unsigned) (hash >> 32) & (MEM_QUICK_BIN_COUNT - 1);
+}
+
+// take a pending node of exactly this size off its quick list, if any,
+// and make it an allocation again
+static alloc_pt _mem_quick_take(pool_mgr_pt pool_mgr, size_t size) {
+    quick_pt quick = pool_mgr->quick;
+    unsigned *slot = &quick->bins[_mem_quick_bin(size)];
+
+    while (*slot != MEM_NODE_NIL && _mem_node_record(pool_mgr, *slot)->size != size) {
+        slot = _mem_node_gap(pool_mgr, *slot);
+    }
+    if (*slot == MEM_NODE_NIL) {
+        return NULL;
+    }
+    unsigned node = *slot;
+    *slot = *_mem_node_gap(pool_mgr, node);
+    quick->pending--;
+
+    alloc_pt record = _mem_node_record(pool_mgr, node);
+    _mem_add_to_addr_ix(pool_mgr, record->mem, node);
+    pool_mgr->pool.num_allocs++;
+    pool_mgr->pool.alloc_size += size;
+    pool_mgr->pool.num_gaps--;
+
+    return record;
+}
+
+// merge all the pending nodes with their neighbors, and empty the lists
+static alloc_status _mem_quick_flush(pool_mgr_pt pool_mgr) {
+    quick_pt quick = pool_mgr->quick;
+
+    for (unsigned bin = 0; bin < MEM_QUICK_BIN_COUNT; ++bin) {
+        while (quick->bins[bin] != MEM_NODE_NIL) {
+            unsigned node = quick->bins[bin];
+            quick->bins[bin] = *_mem_node_gap(pool_mgr, node);
+            quick->pending--;
+            pool_mgr->pool.num_gaps--;
+            if (_mem_merge_gap(pool_mgr, node) != ALLOC_OK) {
+                return ALLOC_FAIL;
+            }
+        }
+    }
+
+    return ALLOC_OK;
+}
+
+// the pool is one free block, unless it's too short for one
+static alloc_status _mem_tag_init(pool_mgr_pt pool_mgr) {
+    tags_pt tags = (tags_pt) calloc(1, sizeof(tags_t));
+    if (tags == NULL) {
+        perror("_mem_tag_init");
+        return ALLOC_FAIL;
+    }
+    pool_mgr->tags = tags;
+
+    size_t region = pool_mgr->pool.total_size / MEM_TAG_ALIGN * MEM_TAG_ALIGN;
+    if (region >= sizeof(alloc_t) + _mem_tag_payload(1) + sizeof(size_t)) {
+        tags->region = region;
+        tags->free_blocks = 1;
+        _mem_tag_write((alloc_pt) pool_mgr->pool.mem, region - sizeof(alloc_t) - sizeof(size_t), 0);
+        _mem_tag_insert(pool_mgr, (alloc_pt) pool_mgr->pool.mem);
+    }
+    _mem_tag_count_gaps(pool_mgr);
+
+    return ALLOC_OK;
+}
+
+// the payload size for a request: enough for the free links, and such
+// that the whole block is a multiple of MEM_TAG_ALIGN
+static size_t _mem_tag_payload(size_t size) {
+    size_t overhead = sizeof(alloc_t) + sizeof(size_t);
+
+    if (size < sizeof(tag_link_t)) {
+        size = sizeof(tag_link_t);
+    }
+
+    return (overhead + size + MEM_TAG_ALIGN - 1) / MEM_TAG_ALIGN * MEM_TAG_ALIGN - overhead;
+}
+
+static size_t *_mem_tag_footer(alloc_pt block) {
+    return (size_t *) ((char *) (block + 1) + block->size);
+}
+
+// the block after, or NULL at the end of the region
+static alloc_pt _mem_tag_next(pool_mgr_pt pool_mgr, alloc_pt block) {
+    char *next = (char *) (_mem_tag_footer(block) + 1);
+
+    return next < pool_mgr->pool.mem + pool_mgr->tags->region ? (alloc_pt) next : NULL;
+}
+
+// the block before, found through its footer, or NULL at the start
+static alloc_pt _mem_tag_prev(pool_mgr_pt pool_mgr, alloc_pt block) {
+    if ((char *) block == pool_mgr->pool.mem) {
+        return NULL;
+    }
+    size_t *footer = (size_t *) block - 1;
+
+    return (alloc_pt) ((char *) footer - *footer) - 1;
+}
+
+static void _mem_tag_write(alloc_pt block, size_t payload, int allocated) {
+    block->mem = allocated ? (char *) (block + 1) : NULL;
+    block->size = payload;
+    *_mem_tag_footer(block) = payload;
+}
+
+static unsigned _mem_tag_bin(size_t payload) {
+    return 63 - (unsigned) __builtin_clzll(payload);
+}
+
+static void _mem_tag_insert(pool_mgr_pt pool_mgr, alloc_pt block) {
+    tags_pt tags = pool_mgr->tags;
+    unsigned bin = _mem_tag_bin(block->size);
+    tag_link_pt link = (tag_link_pt) (block + 1);
+
+    link->next = tags->bins[bin];
+    link->prev = NULL;
+    if (link->next != NULL) {
+        ((tag_link_pt) (link->next + 1))->prev = block;
+    }
+    tags->bins[bin] = block;
+    tags->bin_bitmap |= 1ull << bin;
+}
+
+static void _mem_tag_remove(pool_mgr_pt pool_mgr, alloc_pt block) {
+    tags_pt tags = pool_mgr->tags;
+    unsigned bin = _mem_tag_bin(block->size);
+    tag_link_pt link = (tag_link_pt) (block + 1);
+
+    if (link->prev != NULL) {
+        ((tag_link_pt) (link->prev + 1))->next = link->next;
+    } else {
+        tags->bins[bin] = link->next;
+    }
+    if (link->next != NULL) {
+        ((tag_link_pt) (link->next + 1))->prev = link->prev;
+    }
+    if (tags->bins[bin] == NULL) {
+        tags->bin_bitmap &= ~(1ull << bin);
+    }
+}
+
+// first fit in the bin of the payload size, or else the head of the
+// first larger bin with any, where all blocks fit
+static alloc_pt _mem_tag_find(pool_mgr_pt pool_mgr, size_t payload) {
+    tags_pt tags = pool_mgr->tags;
+    unsigned bin = _mem_tag_bin(payload);
+
+    for (alloc_pt block = tags->bins[bin]; block != NULL; block = ((tag_link_pt) (block + 1))->next) {
+        if (block->size >= payload) {
+            return block;
+        }
+    }
+    unsigned long long larger = bin + 1 < MEM_TAG_BIN_COUNT ? tags->bin_bitmap & (~0ull << (bin + 1)) : 0;
+    if (larger == 0) {
+        return NULL;
+    }
+
+    return tags->bins[__builtin_ctzll(larger)];
+}
+
+// the gaps are the free blocks, and the tail, unless it extends the last
+// block, free
+static void _mem_tag_count_gaps(pool_mgr_pt pool_mgr) {
+    tags_pt tags = pool_mgr->tags;
+    size_t tail = pool_mgr->pool.total_size - tags->region;
+    int tail_merged = 0;
+
+    if (tail > 0 && tags->region > 0) {
+        size_t *footer = (size_t *) (pool_mgr->pool.mem + tags->region) - 1;
+        tail_merged = ((alloc_pt) ((char *) footer - *footer) - 1)->mem == NULL;
+    }
+
+    pool_mgr->pool.num_gaps = tags->free_blocks + (tail > 0 && !tail_merged);
+}
+
+// pop the lowest free object of the first slab of the class with any,
+// making a new slab if there is none
+static alloc_pt _mem_slab_alloc(pool_mgr_pt pool_mgr, size_t size) {
+    slabs_pt slabs = pool_mgr->slabs;
+    unsigned size_class = (unsigned) ((size - 1) >> MEM_SLAB_CLASS_LOG2);
+
+    slab_pt slab = slabs->partial[size_class];
+    if (slab == NULL) {
+        slab = _mem_slab_create(pool_mgr, size_class);
+        if (slab == NULL) {
+            return NULL;
+        }
+    }
+
+    unsigned object = (unsigned) __builtin_ctzll(slab->free_mask);
+    slab->free_mask &= slab->free_mask - 1;
+    // a full slab leaves the list (it is the head)
+    if (slab->free_mask == 0) {
+        slabs->partial[size_class] = slab->next;
+        if (slab->next != NULL) {
+            slab->next->prev = NULL;
+        }
+        slab->next = NULL;
+    }
+
+    size_t object_size = (size_t) (size_class + 1) << MEM_SLAB_CLASS_LOG2;
+    alloc_pt record = &slab->records[object];
+    record->mem = slab->backing->mem + object * object_size;
+    record->size = object_size;
+
+    return record;
+}
+
+// return an object to its slab; an empty slab goes back to the pool,
+// unless it is the last one of its class with free objects
+static alloc_status _mem_slab_free(pool_mgr_pt pool_mgr, slab_pt slab, alloc_pt alloc) {
+    slabs_pt slabs = pool_mgr->slabs;
+    size_t object_size = (size_t) (slab->size_class + 1) << MEM_SLAB_CLASS_LOG2;
+    size_t object = (size_t) (alloc->mem - slab->backing->mem) / object_size;
+
+    // make sure it's the record of a live object of this slab
+    if (object >= MEM_SLAB_OBJECTS || &slab->records[object] != alloc
+        || (slab->free_mask >> object) & 1) {
+        return ALLOC_FAIL;
+    }
+    alloc->mem = NULL;
+    alloc->size = 0;
+
+    // a full slab goes back on the list (at the head)
+    if (slab->free_mask == 0) {
+        slab->next = slabs->partial[slab->size_class];
+        slab->prev = NULL;
+        if (slab->next != NULL) {
+            slab->next->prev = slab;
+        }
+        slabs->partial[slab->size_class] = slab;
+    }
+    slab->free_mask |= 1ull << object;
+
+    if (slab->free_mask == ~0ull && (slab->prev != NULL || slab->next != NULL)) {
+        _mem_slab_release(pool_mgr, slab);
+    }
+
+    return ALLOC_OK;
+}
+
+// carve a new slab out of the pool, and add it to the slab index and to
+// the list of its class
+static slab_pt _mem_slab_create(pool_mgr_pt pool_mgr, unsigned size_class) {
+    slabs_pt slabs = pool_mgr->slabs;
+
+    // note: larger than max_size, so it is a general allocation
+    alloc_pt backing = mem_new_alloc((pool_pt) pool_mgr,
+                                     ((size_t) (size_class + 1) << MEM_SLAB_CLASS_LOG2) * MEM_SLAB_OBJECTS);
+    if (backing == NULL) {
+        return NULL;
+    }
+
+    // reuse a released slab, if any
+    slab_pt slab = slabs->spare;
+    if (slab != NULL) {
+        slabs->spare = slab->next;
+    } else {
+        // a new slab takes the next entry of the slab index, expanding it
+        // if necessary
+        if (slabs->slab_ix_size == slabs->slab_ix_capacity) {
+            unsigned capacity = slabs->slab_ix_capacity * MEM_SLAB_IX_EXPAND_FACTOR;
+            slab_pt *slab_ix = (slab_pt *) realloc(slabs->slab_ix, capacity * sizeof(slab_pt));
+            if (slab_ix == NULL) {
+                perror("_mem_slab_create");
+                mem_del_alloc((pool_pt) pool_mgr, backing);
+                return NULL;
+            }
+            slabs->slab_ix = slab_ix;
+            slabs->slab_ix_capacity = capacity;
+        }
+        slab = (slab_pt) calloc(1, sizeof(slab_t));
+        if (slab == NULL) {
+            perror("_mem_slab_create");
+            mem_del_alloc((pool_pt) pool_mgr, backing);
+            return NULL;
+        }
+        slab->ix = slabs->slab_ix_size++;
+        slabs->slab_ix[slab->ix] = slab;
+    }
+    slab->backing = backing;
+    slab->prev = NULL;
+    slab->size_class = size_class;
+    slab->free_mask = ~0ull;
+
+    slab->link.left = MEM_AVL_NIL;
+    slab->link.right = MEM_AVL_NIL;
+    slab->link.height = 1;
+    slabs->slab_ix_root = _mem_avl_insert(&slab_ix_ops, pool_mgr, slabs->slab_ix_root, slab->ix, backing->mem);
+
+    slab->next = slabs->partial[size_class];
+    if (slab->next != NULL) {
+        slab->next->prev = slab;
+    }
+    slabs->partial[size_class] = slab;
+
+    return slab;
+}
+
+// give an empty slab back to the pool
+static void _mem_slab_release(pool_mgr_pt pool_mgr, slab_pt slab) {
+    slabs_pt slabs = pool_mgr->slabs;
+
+    if (slab->prev != NULL) {
+        slab->prev->next = slab->next;
+    } else {
+        slabs->partial[slab->size_class] = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->prev = slab->prev;
+    }
+
+    unsigned removed = MEM_AVL_NIL;
+    slabs->slab_ix_root = _mem_avl_remove(&slab_ix_ops, pool_mgr, slabs->slab_ix_root, slab->backing->mem, &removed);
+
+    mem_del_alloc((pool_pt) pool_mgr, slab->backing);
+    slab->backing = NULL;
+    slab->next = slabs->spare;
+    slabs->spare = slab;
+}
+
+// the slab whose memory holds mem, if any
+static slab_pt _mem_slab_find(pool_mgr_pt pool_mgr, const char *mem) {
+    slabs_pt slabs = pool_mgr->slabs;
+    slab_pt slab = NULL;
+
+    if (mem == NULL) {
+        return NULL;
+    }
+
+    // find the last slab at or below mem: only it may hold mem
+    for (unsigned root = slabs->slab_ix_root; root != MEM_AVL_NIL;) {
+        slab_pt entry = slabs->slab_ix[root];
+        if (entry->backing->mem <= mem) {
+            slab = entry;
+            root = entry->link.right;
+        } else {
+            root = entry->link.left;
+        }
+    }
+
+    return slab != NULL && mem < slab->backing->mem + slab->backing->size ? slab : NULL;
+}
+
+static avl_link_pt _mem_slab_link(pool_mgr_pt pool_mgr, unsigned slab) {
+    return &pool_mgr->slabs->slab_ix[slab]->link;
+}
+
+static int _mem_slab_cmp(pool_mgr_pt pool_mgr, const void *key, unsigned slab) {
+    const char *mem = (const char *) key;
+    const char *slab_mem = pool_mgr->slabs->slab_ix[slab]->backing->mem;
+
+    if (mem != slab_mem) {
+        return mem < slab_mem ? -1 : 1;
+    }
+    return 0;
+}
@@ -9,13 +9,18 @@
 
 /* type declarations */
 
-typedef enum _alloc_policy { FIRST_FIT, BEST_FIT } alloc_policy;
+typedef enum _alloc_policy { FIRST_FIT, BEST_FIT, TLSF, BUDDY, FIXED, ARENA, LIFO, RING, BITMAP, TAGGED, NEXT_FIT, WORST_FIT, HUGE_FIT } alloc_policy;
+
+typedef enum _pool_backing { MALLOC_BACKED, MMAP_BACKED, HUGETLB_BACKED, THP_BACKED } pool_backing;
 
 typedef struct _pool {
     char *mem;
     alloc_policy policy;
+    pool_backing backing;
     size_t total_size;
     size_t alloc_size;
+    size_t committed_size; // backed by memory (by pages, if reserved)
+    size_t reserved_size; // of address space
     unsigned num_allocs;
     unsigned num_gaps;
 } pool_t, *pool_pt;
@@ -30,6 +35,11 @@ typedef struct _pool_segment {
     unsigned long allocated; // 1-allocation, 0-gap (note: 8 bytes)
 } pool_segment_t, *pool_segment_pt;
 
+typedef struct _pool_mark {
+    size_t alloc_size;
+    unsigned num_allocs;
+} pool_mark_t;
+
 typedef enum _alloc_status {
     ALLOC_OK,
     ALLOC_FAIL,
@@ -48,15 +58,59 @@ mem_free();
 pool_pt
 mem_pool_open(size_t size, alloc_policy policy);
 
+pool_pt
+mem_pool_open_reserved(size_t size, size_t reserve, alloc_policy policy);
+
+pool_pt
+mem_pool_open_huge(size_t size, alloc_policy policy);
+
+pool_pt
+mem_pool_open_fixed(size_t obj_size, size_t count);
+
 alloc_status
 mem_pool_close(pool_pt pool);
 
+alloc_status
+mem_pool_reset(pool_pt pool);
+
+pool_mark_t
+mem_pool_mark(pool_pt pool);
+
+alloc_status
+mem_pool_rollback(pool_pt pool, pool_mark_t mark);
+
+alloc_status
+mem_pool_enable_slabs(pool_pt pool, size_t max_size);
+
+alloc_status
+mem_pool_defer_frees(pool_pt pool, unsigned max_pending);
+
+alloc_status
+mem_pool_enable_growth(pool_pt pool, size_t region_size);
+
+alloc_status
+mem_pool_decommit_gaps(pool_pt pool, size_t retain);
+
+// sizes the node heap, gap index and address index of a list policy pool
+// for max_allocs allocations, so that allocating and freeing never grow them
+// note: otherwise the metadata grows by doubling, so the time bounds of the
+// policies (e.g. constant for TLSF) are amortized only
+alloc_status
+mem_pool_reserve_metadata(pool_pt pool, unsigned max_allocs);
+
+// note: amortized time, unless the metadata is reserved (see above)
 alloc_pt
 mem_new_alloc(pool_pt pool, size_t size);
 
 alloc_status
 mem_del_alloc(pool_pt pool, alloc_pt alloc);
 
+char *
+mem_new_alloc_addr(pool_pt pool, size_t size);
+
+alloc_status
+mem_del_alloc_addr(pool_pt pool, char *mem);
+
 void
 mem_inspect_pool(pool_pt pool, pool_segment_pt *segments, unsigned *num_segments);
 
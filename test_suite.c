@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h> // for uintptr_t
 
 #include <stdarg.h>
 #include <stddef.h>
@@ -2316,13 +2317,2002 @@ static void test_pool_scenario19(void **state) {
 }
 
 /*******************************************/
-/***          5. STRESS TEST             ***/
-/***                                     ***/
-/***         [non-functional]            ***/
-/***         [see NOTE below]            ***/
+/***          5. TLSF SCENARIOS          ***/
+/*******************************************/
+
+static int pool_tlsf_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "TLSF");
+    pool = mem_pool_open(POOL_SIZE, TLSF);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_tlsf_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario20(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 20:
+     *
+     * 1. Pool is a gap.
+     * 2. Allocate 100, 1000, 10000.
+     * 3. Deallocate the 1000.
+     * 4. Allocate 500. The request is rounded up to its size class
+     *    [512, 544), and the first non-empty class at or above it is
+     *    that of the 1000 gap, which is carved from the top.
+     * 5. Allocate 1000. No gap of class [1024, 1088) or above, other
+     *    than the remainder of the pool, so that is used.
+     * 6. Deallocate everything. Pool is again one single gap.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_metadata(pool, TLSF, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 10000);
+    assert_non_null(alloc2);
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp1[4] =
+            {
+                    {100, 1},
+                    {1000, 0},
+                    {10000, 1},
+                    {pool->total_size - 11100, 0}
+            };
+    check_pool(pool, exp1);
+
+
+    alloc1 = mem_new_alloc(pool, 500);
+    assert_non_null(alloc1);
+
+    pool_segment_t exp2[5] =
+            {
+                    {100, 1},
+                    {500, 1},
+                    {500, 0},
+                    {10000, 1},
+                    {pool->total_size - 11100, 0}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, TLSF, pool->total_size, 10600, 3, 2);
+
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc3);
+
+    pool_segment_t exp3[6] =
+            {
+                    {100, 1},
+                    {500, 1},
+                    {500, 0},
+                    {10000, 1},
+                    {1000, 1},
+                    {pool->total_size - 12100, 0}
+            };
+    check_pool(pool, exp3);
+
+
+    assert_int_equal(mem_del_alloc(pool, alloc1), ALLOC_OK);
+    assert_int_equal(mem_del_alloc(pool, alloc3), ALLOC_OK);
+    assert_int_equal(mem_del_alloc(pool, alloc0), ALLOC_OK);
+    assert_int_equal(mem_del_alloc(pool, alloc2), ALLOC_OK);
+
+    check_pool(pool, exp0);
+}
+
+/*******************************************/
+/***         6. BUDDY SCENARIOS          ***/
+/*******************************************/
+
+static int pool_buddy_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "BUDDY");
+    pool = mem_pool_open(POOL_SIZE, BUDDY);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_buddy_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario21(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 21:
+     *
+     * 1. Pool is carved into the largest power-of-two blocks that
+     *    fit, in decreasing size: 1000000 bytes make 7 blocks.
+     * 2. Allocate 600000. No block is large enough.
+     * 3. Allocate 100. Rounded up to 128, so the 512 block is split
+     *    into 128 + 128 + 256, and the lower 128 is allocated.
+     * 4. Allocate 64 and 200. The 64 block and the 256 block fit.
+     * 5. Deallocate the 100. Its buddy is free, so they merge into
+     *    a 256, whose buddy is allocated.
+     * 6. Deallocate the 200. The two 256 buddies merge back into
+     *    the 512, which has no buddy in the pool.
+     * 7. Deallocate the 64. Pool is again the 7 blocks.
+     */
+
+    pool_segment_t exp0[7] =
+            {
+                    {524288, 0},
+                    {262144, 0},
+                    {131072, 0},
+                    {65536, 0},
+                    {16384, 0},
+                    {512, 0},
+                    {64, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, BUDDY, pool->total_size, 0, 0, 7);
+
+
+    assert_null(mem_new_alloc(pool, 600000));
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    assert_int_equal(alloc0->size, 128);
+
+    pool_segment_t exp1[9] =
+            {
+                    {524288, 0},
+                    {262144, 0},
+                    {131072, 0},
+                    {65536, 0},
+                    {16384, 0},
+                    {128, 1},
+                    {128, 0},
+                    {256, 0},
+                    {64, 0}
+            };
+    check_pool(pool, exp1);
+
+
+    alloc_pt alloc1 = mem_new_alloc(pool, 64);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 200);
+    assert_non_null(alloc2);
+
+    pool_segment_t exp2[9] =
+            {
+                    {524288, 0},
+                    {262144, 0},
+                    {131072, 0},
+                    {65536, 0},
+                    {16384, 0},
+                    {128, 1},
+                    {128, 0},
+                    {256, 1},
+                    {64, 1}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, BUDDY, pool->total_size, 448, 3, 6);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp3[8] =
+            {
+                    {524288, 0},
+                    {262144, 0},
+                    {131072, 0},
+                    {65536, 0},
+                    {16384, 0},
+                    {256, 0},
+                    {256, 1},
+                    {64, 1}
+            };
+    check_pool(pool, exp3);
+
+
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp4[7] =
+            {
+                    {524288, 0},
+                    {262144, 0},
+                    {131072, 0},
+                    {65536, 0},
+                    {16384, 0},
+                    {512, 0},
+                    {64, 1}
+            };
+    check_pool(pool, exp4);
+
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, BUDDY, pool->total_size, 0, 0, 7);
+}
+
+/*******************************************/
+/***         7. FIXED SCENARIOS          ***/
+/*******************************************/
+
+static int pool_fixed_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %u objects of %u bytes\n", 4, 24);
+    pool = mem_pool_open_fixed(24, 4);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_fixed_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario22(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 22:
+     *
+     * 1. Pool is 4 free blocks of 24 bytes.
+     * 2. Allocate 24 and 10. Both take a whole block, from the
+     *    lowest address up. Allocate 25. Too large for a block.
+     * 3. Deallocate the first. Allocate 24. The freed block is on
+     *    top of the free stack, so it is reused.
+     * 4. Allocate two more. Pool is full, so allocate one more fails.
+     * 5. Deallocate the second by address, then again by record,
+     *    which fails.
+     * 6. Deallocate everything. Pool is again 4 free blocks.
+     */
+
+    pool_segment_t exp0[4] =
+            {
+                    {24, 0},
+                    {24, 0},
+                    {24, 0},
+                    {24, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, FIXED, 96, 0, 0, 4);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 24);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 10);
+    assert_non_null(alloc1);
+    assert_int_equal(alloc1->size, 24);
+    assert_ptr_equal(alloc1->mem, pool->mem + 24);
+    assert_null(mem_new_alloc(pool, 25));
+
+    pool_segment_t exp1[4] =
+            {
+                    {24, 1},
+                    {24, 1},
+                    {24, 0},
+                    {24, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, FIXED, 96, 48, 2, 2);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    alloc0 = mem_new_alloc(pool, 24);
+    assert_non_null(alloc0);
+    assert_ptr_equal(alloc0->mem, pool->mem);
+
+    alloc_pt alloc2 = mem_new_alloc(pool, 24);
+    assert_non_null(alloc2);
+    alloc_pt alloc3 = mem_new_alloc(pool, 24);
+    assert_non_null(alloc3);
+    assert_null(mem_new_alloc(pool, 24));
+    check_metadata(pool, FIXED, 96, 96, 4, 0);
+
+
+    status = mem_del_alloc_addr(pool, pool->mem + 24);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_FAIL);
+
+    pool_segment_t exp2[4] =
+            {
+                    {24, 1},
+                    {24, 0},
+                    {24, 1},
+                    {24, 1}
+            };
+    check_pool(pool, exp2);
+
+
+    assert_int_equal(mem_del_alloc(pool, alloc0), ALLOC_OK);
+    assert_int_equal(mem_del_alloc(pool, alloc2), ALLOC_OK);
+    assert_int_equal(mem_del_alloc(pool, alloc3), ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, FIXED, 96, 0, 0, 4);
+}
+
+/*******************************************/
+/***         8. ARENA SCENARIOS          ***/
+/*******************************************/
+
+static int pool_arena_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "ARENA");
+    pool = mem_pool_open(POOL_SIZE, ARENA);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_arena_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario23(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 23:
+     *
+     * 1. Pool is a gap.
+     * 2. Allocate 100, 1000, 10000. Each starts where the last ended.
+     * 3. Deallocate the 1000. Nothing changes.
+     * 4. Allocate one byte more than is left, which fails, then
+     *    exactly what is left. No gap remains.
+     * 5. Close the pool, which fails, since allocations remain.
+     * 6. Reset the pool. Pool is again a gap, and the next
+     *    allocation is at its start.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, ARENA, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 10000);
+    assert_non_null(alloc2);
+    assert_ptr_equal(alloc1->mem, alloc0->mem + 100);
+    assert_ptr_equal(alloc2->mem, alloc1->mem + 1000);
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp1[4] =
+            {
+                    {100, 1},
+                    {1000, 1},
+                    {10000, 1},
+                    {pool->total_size - 11100, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, ARENA, pool->total_size, 11100, 3, 1);
+
+
+    assert_null(mem_new_alloc(pool, pool->total_size - 11100 + 1));
+    alloc_pt alloc3 = mem_new_alloc(pool, pool->total_size - 11100);
+    assert_non_null(alloc3);
+    check_metadata(pool, ARENA, pool->total_size, pool->total_size, 4, 0);
+
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_NOT_FREED);
+
+
+    status = mem_pool_reset(pool);
+    assert_int_equal(status, ALLOC_OK);
+    check_pool(pool, exp0);
+    check_metadata(pool, ARENA, pool->total_size, 0, 0, 1);
+
+    alloc0 = mem_new_alloc(pool, 50);
+    assert_non_null(alloc0);
+    assert_ptr_equal(alloc0->mem, pool->mem);
+
+    status = mem_pool_reset(pool);
+    assert_int_equal(status, ALLOC_OK);
+}
+
+/*******************************************/
+/***          9. LIFO SCENARIOS          ***/
+/*******************************************/
+
+static int pool_lifo_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "LIFO");
+    pool = mem_pool_open(POOL_SIZE, LIFO);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_lifo_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario24(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 24:
+     *
+     * 1. Pool is a gap.
+     * 2. Allocate 100, mark, then allocate 200, 300.
+     * 3. Deallocate the 200, which fails, since it is not the
+     *    latest. Deallocate the 300.
+     * 4. Allocate 300 again, then roll back to the mark. Only the
+     *    100 is left.
+     * 5. Allocate 50, mark again, roll back to the first mark. The
+     *    second mark is now past the top, so rolling back to it fails.
+     * 6. Deallocate the 100 by address. Pool is again a gap.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, LIFO, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    pool_mark_t mark0 = mem_pool_mark(pool);
+    alloc_pt alloc1 = mem_new_alloc(pool, 200);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 300);
+    assert_non_null(alloc2);
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_FAIL);
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp1[3] =
+            {
+                    {100, 1},
+                    {200, 1},
+                    {pool->total_size - 300, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, LIFO, pool->total_size, 300, 2, 1);
+
+
+    alloc2 = mem_new_alloc(pool, 300);
+    assert_non_null(alloc2);
+    status = mem_pool_rollback(pool, mark0);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp2[2] =
+            {
+                    {100, 1},
+                    {pool->total_size - 100, 0}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, LIFO, pool->total_size, 100, 1, 1);
+
+
+    alloc1 = mem_new_alloc(pool, 50);
+    assert_non_null(alloc1);
+    assert_ptr_equal(alloc1->mem, alloc0->mem + 100);
+    pool_mark_t mark1 = mem_pool_mark(pool);
+    status = mem_pool_rollback(pool, mark0);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_pool_rollback(pool, mark1);
+    assert_int_equal(status, ALLOC_FAIL);
+    check_pool(pool, exp2);
+
+
+    status = mem_del_alloc_addr(pool, alloc0->mem);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, LIFO, pool->total_size, 0, 0, 1);
+}
+
+/*******************************************/
+/***         10. RING SCENARIOS          ***/
+/*******************************************/
+
+static int pool_ring_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "RING");
+    pool = mem_pool_open(POOL_SIZE, RING);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_ring_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario25(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 25:
+     *
+     * 1. Pool is a gap.
+     * 2. Allocate 400000, 400000, 100000.
+     * 3. Deallocate the second 400000. It is not at the tail, so it
+     *    waits there as a gap.
+     * 4. Deallocate the first 400000. The tail reclaims both.
+     * 5. Allocate 300000. The end of the pool is too short, so it
+     *    wraps around to the start.
+     * 6. Allocate 600000. Only 500000 are left up to the tail.
+     * 7. Deallocate the 100000. The tail wraps around as well.
+     * 8. Deallocate the 300000. Pool is again one single gap.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, RING, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 400000);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 400000);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 100000);
+    assert_non_null(alloc2);
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp1[4] =
+            {
+                    {400000, 1},
+                    {400000, 0},
+                    {100000, 1},
+                    {100000, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, RING, pool->total_size, 500000, 2, 2);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp2[3] =
+            {
+                    {800000, 0},
+                    {100000, 1},
+                    {100000, 0}
+            };
+    check_pool(pool, exp2);
+
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 300000);
+    assert_non_null(alloc3);
+    assert_ptr_equal(alloc3->mem, pool->mem);
+    assert_null(mem_new_alloc(pool, 600000));
+
+    pool_segment_t exp3[4] =
+            {
+                    {300000, 1},
+                    {500000, 0},
+                    {100000, 1},
+                    {100000, 0}
+            };
+    check_pool(pool, exp3);
+    check_metadata(pool, RING, pool->total_size, 400000, 2, 2);
+
+
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp4[2] =
+            {
+                    {300000, 1},
+                    {700000, 0}
+            };
+    check_pool(pool, exp4);
+
+
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, RING, pool->total_size, 0, 0, 1);
+}
+
+/*******************************************/
+/***         11. BITMAP SCENARIOS        ***/
+/*******************************************/
+
+static int pool_bitmap_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "BITMAP");
+    pool = mem_pool_open(POOL_SIZE, BITMAP);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_bitmap_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario26(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 26:
+     *
+     * 1. Pool is a gap.
+     * 2. Allocate 100, 30, 2000. They are rounded up to 16-byte
+     *    granules: 112, 32, 2000.
+     * 3. Deallocate the 30. Its granules are a gap.
+     * 4. Allocate 20. It is rounded up to 32 and fills the gap.
+     * 5. Allocate 5000. It goes after the 2000.
+     * 6. Deallocate the 2000 and the 20. The 112 is surrounded by gaps.
+     * 7. Deallocate the 5000 and the 100. Pool is again one single gap.
+     * 8. Allocate 100 and 30 by address, with no records. Deallocating
+     *    from the middle of the 100 fails; by their addresses, it works.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, BITMAP, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 30);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 2000);
+    assert_non_null(alloc2);
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp1[4] =
+            {
+                    {112, 1},
+                    {32, 0},
+                    {2000, 1},
+                    {pool->total_size - 2144, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, BITMAP, pool->total_size, 2112, 2, 2);
+
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 20);
+    assert_non_null(alloc3);
+    assert_ptr_equal(alloc3->mem, pool->mem + 112);
+    alloc_pt alloc4 = mem_new_alloc(pool, 5000);
+    assert_non_null(alloc4);
+
+    pool_segment_t exp2[5] =
+            {
+                    {112, 1},
+                    {32, 1},
+                    {2000, 1},
+                    {5008, 1},
+                    {pool->total_size - 7152, 0}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, BITMAP, pool->total_size, 7152, 4, 1);
+
+
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp3[4] =
+            {
+                    {112, 1},
+                    {2032, 0},
+                    {5008, 1},
+                    {pool->total_size - 7152, 0}
+            };
+    check_pool(pool, exp3);
+    check_metadata(pool, BITMAP, pool->total_size, 5120, 2, 2);
+
+
+    status = mem_del_alloc(pool, alloc4);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, BITMAP, pool->total_size, 0, 0, 1);
+
+
+    char *mem0 = mem_new_alloc_addr(pool, 100);
+    assert_ptr_equal(mem0, pool->mem);
+    char *mem1 = mem_new_alloc_addr(pool, 30);
+    assert_ptr_equal(mem1, pool->mem + 112);
+
+    pool_segment_t exp4[3] =
+            {
+                    {112, 1},
+                    {32, 1},
+                    {pool->total_size - 144, 0}
+            };
+    check_pool(pool, exp4);
+    check_metadata(pool, BITMAP, pool->total_size, 144, 2, 1);
+
+    status = mem_del_alloc_addr(pool, mem0 + 16);
+    assert_int_equal(status, ALLOC_FAIL);
+    status = mem_del_alloc_addr(pool, mem0);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc_addr(pool, mem0);
+    assert_int_equal(status, ALLOC_FAIL);
+    status = mem_del_alloc_addr(pool, mem1);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, BITMAP, pool->total_size, 0, 0, 1);
+}
+
+/*******************************************/
+/***         12. SLAB SCENARIOS          ***/
+/*******************************************/
+
+static int pool_slab_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s and slabs\n", (long) POOL_SIZE, "FIRST_FIT");
+    pool = mem_pool_open(POOL_SIZE, FIRST_FIT);
+    assert_non_null(pool);
+
+    status = mem_pool_enable_slabs(pool, 256);
+    assert_int_equal(status, ALLOC_OK);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_slab_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario27(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 27:
+     *
+     * 1. Pool is a gap. Slabs are enabled, for up to 256 bytes.
+     * 2. Allocate 20 and 30. Both are in the 32-byte class, and share
+     *    one slab of 64 objects (2048).
+     * 3. Allocate 1000. It is too large for a slab.
+     * 4. Allocate 100. It is in the 112-byte class, in a new slab (7168).
+     * 5. Deallocate the 30 (by address) and the 20. Their slab is the
+     *    last of its class, so it stays.
+     * 6. Deallocate the 1000 and the 100. Closing the pool gives the
+     *    slabs back.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 0, 0, 1);
+
+    status = mem_pool_enable_slabs(pool, 256);
+    assert_int_equal(status, ALLOC_FAIL);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 20);
+    assert_non_null(alloc0);
+    assert_int_equal(alloc0->size, 32);
+    alloc_pt alloc1 = mem_new_alloc(pool, 30);
+    assert_non_null(alloc1);
+    assert_ptr_equal(alloc1->mem, alloc0->mem + 32);
+    alloc_pt alloc2 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc2);
+
+    pool_segment_t exp1[3] =
+            {
+                    {2048, 1},
+                    {1000, 1},
+                    {pool->total_size - 3048, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 3048, 2, 1);
+
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc3);
+    assert_int_equal(alloc3->size, 112);
+
+    status = mem_del_alloc_addr(pool, alloc1->mem);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_FAIL);
+
+    pool_segment_t exp2[4] =
+            {
+                    {2048, 1},
+                    {1000, 1},
+                    {7168, 1},
+                    {pool->total_size - 10216, 0}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 10216, 3, 1);
+
+
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp3[4] =
+            {
+                    {2048, 1},
+                    {1000, 0},
+                    {7168, 1},
+                    {pool->total_size - 10216, 0}
+            };
+    check_pool(pool, exp3);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 9216, 2, 2);
+}
+
+/*******************************************/
+/***         13. TAGGED SCENARIOS        ***/
+/*******************************************/
+
+static int pool_tagged_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "TAGGED");
+    pool = mem_pool_open(POOL_SIZE, TAGGED);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_tagged_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario28(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 28:
+     *
+     * 1. Pool is a gap. The segments are whole blocks: a 16-byte
+     *    header, the payload, and an 8-byte footer, 16-byte aligned.
+     * 2. Allocate 100, 1000, 50 (blocks of 128, 1024, 80).
+     * 3. Deallocate the 1000.
+     * 4. Allocate 900. It splits the free block: 928 and 96.
+     * 5. Deallocate the 100, then the 900, which merges with both of
+     *    its neighbors.
+     * 6. Deallocate the 50. Pool is again one single gap.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, TAGGED, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    assert_ptr_equal(alloc0->mem, (char *) (alloc0 + 1));
+    assert_int_equal(alloc0->size, 104);
+    alloc_pt alloc1 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 50);
+    assert_non_null(alloc2);
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp1[4] =
+            {
+                    {128, 1},
+                    {1024, 0},
+                    {80, 1},
+                    {pool->total_size - 1232, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, TAGGED, pool->total_size, 208, 2, 2);
+
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 900);
+    assert_non_null(alloc3);
+    assert_ptr_equal(alloc3, alloc1);
+
+    pool_segment_t exp2[5] =
+            {
+                    {128, 1},
+                    {928, 1},
+                    {96, 0},
+                    {80, 1},
+                    {pool->total_size - 1232, 0}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, TAGGED, pool->total_size, 1136, 3, 2);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc_addr(pool, alloc3->mem);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_FAIL);
+
+    pool_segment_t exp3[3] =
+            {
+                    {1152, 0},
+                    {80, 1},
+                    {pool->total_size - 1232, 0}
+            };
+    check_pool(pool, exp3);
+    check_metadata(pool, TAGGED, pool->total_size, 80, 1, 2);
+
+
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, TAGGED, pool->total_size, 0, 0, 1);
+}
+
+/*******************************************/
+/***         14. DEFERRED SCENARIOS      ***/
+/*******************************************/
+
+static int pool_deferred_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s and deferred frees\n", (long) POOL_SIZE, "FIRST_FIT");
+    pool = mem_pool_open(POOL_SIZE, FIRST_FIT);
+    assert_non_null(pool);
+
+    status = mem_pool_defer_frees(pool, 3);
+    assert_int_equal(status, ALLOC_OK);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_deferred_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario29(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 29:
+     *
+     * 1. Pool is a gap. Frees are deferred, up to 3 pending.
+     * 2. Allocate 100, 200, 300, 400.
+     * 3. Deallocate the 200. It is pending, not merged.
+     * 4. Allocate 200. It reuses the pending one.
+     * 5. Deallocate the 200 and the 300. They are pending, side by side.
+     * 6. Deallocate the 100. With 3 pending, they are all merged.
+     * 7. Deallocate the 400. It is pending.
+     * 8. Allocate the whole pool. No gap is large enough, so the
+     *    pending one is merged first.
+     * 9. Deallocate it. Closing the pool merges it.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 200);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 300);
+    assert_non_null(alloc2);
+    alloc_pt alloc3 = mem_new_alloc(pool, 400);
+    assert_non_null(alloc3);
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp1[5] =
+            {
+                    {100, 1},
+                    {200, 0},
+                    {300, 1},
+                    {400, 1},
+                    {pool->total_size - 1000, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 800, 3, 2);
+
+
+    alloc_pt alloc4 = mem_new_alloc(pool, 200);
+    assert_ptr_equal(alloc4, alloc1);
+    assert_ptr_equal(alloc4->mem, alloc0->mem + 100);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 1000, 4, 1);
+
+    status = mem_del_alloc(pool, alloc4);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_FAIL);
+
+    pool_segment_t exp2[5] =
+            {
+                    {100, 1},
+                    {200, 0},
+                    {300, 0},
+                    {400, 1},
+                    {pool->total_size - 1000, 0}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 500, 2, 3);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp3[3] =
+            {
+                    {600, 0},
+                    {400, 1},
+                    {pool->total_size - 1000, 0}
+            };
+    check_pool(pool, exp3);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 400, 1, 2);
+
+
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_OK);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 0, 0, 3);
+
+    alloc_pt alloc5 = mem_new_alloc(pool, pool->total_size);
+    assert_non_null(alloc5);
+    check_metadata(pool, FIRST_FIT, pool->total_size, pool->total_size, 1, 0);
+
+    status = mem_del_alloc(pool, alloc5);
+    assert_int_equal(status, ALLOC_OK);
+    check_metadata(pool, FIRST_FIT, pool->total_size, 0, 0, 1);
+}
+
+/*******************************************/
+/***         15. NEXT_FIT SCENARIOS      ***/
+/*******************************************/
+
+static int pool_next_fit_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "NEXT_FIT");
+    pool = mem_pool_open(POOL_SIZE, NEXT_FIT);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_next_fit_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario30(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 30:
+     *
+     * 1. Pool is a gap.
+     * 2. Allocate 100, 100, 100. Deallocate the first 100.
+     * 3. Allocate 50. It goes after the last allocation, not in the
+     *    gap at the start.
+     * 4. Allocate the rest of the pool.
+     * 5. Allocate 60. Nothing is left past the last allocation, so the
+     *    search wraps around to the gap at the start.
+     * 6. Deallocate everything. Pool is again one single gap.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, NEXT_FIT, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc2);
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 50);
+    assert_non_null(alloc3);
+    assert_ptr_equal(alloc3->mem, pool->mem + 300);
+
+    pool_segment_t exp1[5] =
+            {
+                    {100, 0},
+                    {100, 1},
+                    {100, 1},
+                    {50, 1},
+                    {pool->total_size - 350, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, NEXT_FIT, pool->total_size, 250, 3, 2);
+
+
+    alloc_pt alloc4 = mem_new_alloc(pool, pool->total_size - 350);
+    assert_non_null(alloc4);
+    alloc_pt alloc5 = mem_new_alloc(pool, 60);
+    assert_non_null(alloc5);
+    assert_ptr_equal(alloc5->mem, pool->mem);
+
+    pool_segment_t exp2[6] =
+            {
+                    {60, 1},
+                    {40, 0},
+                    {100, 1},
+                    {100, 1},
+                    {50, 1},
+                    {pool->total_size - 350, 1}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, NEXT_FIT, pool->total_size, pool->total_size - 40, 5, 1);
+
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc5);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc4);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, NEXT_FIT, pool->total_size, 0, 0, 1);
+}
+
+/*******************************************/
+/***         16. WORST_FIT SCENARIOS     ***/
+/*******************************************/
+
+static int pool_worst_fit_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "WORST_FIT");
+    pool = mem_pool_open(POOL_SIZE, WORST_FIT);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_worst_fit_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario31(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 31:
+     *
+     * 1. Pool is a gap.
+     * 2. Allocate 1000, 10, 3000, 10, and the rest of the pool.
+     * 3. Deallocate the 1000 and the 3000.
+     * 4. Allocate 500. It is carved from the 3000 gap, the largest,
+     *    although the 1000 gap fits too.
+     * 5. Allocate 2600. No gap is large enough.
+     * 6. Allocate 2500. It takes the whole remainder of the 3000 gap.
+     * 7. Deallocate everything. Pool is again one single gap.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {pool->total_size, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, WORST_FIT, pool->total_size, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 10);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 3000);
+    assert_non_null(alloc2);
+    alloc_pt alloc3 = mem_new_alloc(pool, 10);
+    assert_non_null(alloc3);
+    alloc_pt alloc4 = mem_new_alloc(pool, pool->total_size - 4020);
+    assert_non_null(alloc4);
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+
+    alloc_pt alloc5 = mem_new_alloc(pool, 500);
+    assert_non_null(alloc5);
+    assert_ptr_equal(alloc5->mem, pool->mem + 1010);
+
+    pool_segment_t exp1[6] =
+            {
+                    {1000, 0},
+                    {10, 1},
+                    {500, 1},
+                    {2500, 0},
+                    {10, 1},
+                    {pool->total_size - 4020, 1}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, WORST_FIT, pool->total_size, pool->total_size - 3500, 4, 2);
+
+
+    assert_null(mem_new_alloc(pool, 2600));
+    alloc_pt alloc6 = mem_new_alloc(pool, 2500);
+    assert_non_null(alloc6);
+
+    pool_segment_t exp2[6] =
+            {
+                    {1000, 0},
+                    {10, 1},
+                    {500, 1},
+                    {2500, 1},
+                    {10, 1},
+                    {pool->total_size - 4020, 1}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, WORST_FIT, pool->total_size, pool->total_size - 1000, 5, 1);
+
+
+    status = mem_del_alloc(pool, alloc6);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc4);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc5);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_OK);
+
+    check_pool(pool, exp0);
+    check_metadata(pool, WORST_FIT, pool->total_size, 0, 0, 1);
+}
+
+/*******************************************/
+/***         17. GROWABLE SCENARIOS      ***/
+/*******************************************/
+
+static int pool_growable_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Allocating growable pool of %lu bytes with policy %s\n", (long) POOL_SIZE, "FIRST_FIT");
+    pool = mem_pool_open(POOL_SIZE, FIRST_FIT);
+    assert_non_null(pool);
+
+    status = mem_pool_enable_growth(pool, 100000);
+    assert_int_equal(status, ALLOC_OK);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_growable_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario32(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 32:
+     *
+     * 1. Pool is a gap. It grows by regions of at least 100000.
+     * 2. Allocate the whole pool.
+     * 3. Allocate 1000. A region of 100000 is added for it.
+     * 4. Allocate 200000. A region of 200000 is added for it.
+     * 5. Deallocate the first allocation and the 1000. The gaps of the
+     *    first two regions are next to each other in the node list,
+     *    but don't merge.
+     * 6. Deallocate the 200000. Only the largest empty region is kept,
+     *    so the 100000 one is freed.
+     */
+
+    pool_segment_t exp0[1] =
+            {
+                    {POOL_SIZE, 0}
+            };
+    check_pool(pool, exp0);
+    check_metadata(pool, FIRST_FIT, POOL_SIZE, 0, 0, 1);
+
+
+    alloc_pt alloc0 = mem_new_alloc(pool, POOL_SIZE);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc1);
+    alloc_pt alloc2 = mem_new_alloc(pool, 200000);
+    assert_non_null(alloc2);
+
+    pool_segment_t exp1[4] =
+            {
+                    {POOL_SIZE, 1},
+                    {1000, 1},
+                    {99000, 0},
+                    {200000, 1}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, FIRST_FIT, POOL_SIZE + 300000, POOL_SIZE + 201000, 3, 1);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp2[3] =
+            {
+                    {POOL_SIZE, 0},
+                    {100000, 0},
+                    {200000, 1}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, FIRST_FIT, POOL_SIZE + 300000, 200000, 1, 2);
+
+
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp3[2] =
+            {
+                    {POOL_SIZE, 0},
+                    {200000, 0}
+            };
+    check_pool(pool, exp3);
+    check_metadata(pool, FIRST_FIT, POOL_SIZE + 200000, 0, 0, 2);
+}
+
+/*******************************************/
+/***         18. RESERVED SCENARIOS      ***/
+/*******************************************/
+
+static int pool_reserved_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Reserving %lu bytes for a pool of %lu bytes with policy %s\n",
+         (long) (4 << 20), (long) (1 << 20), "FIRST_FIT");
+    pool = mem_pool_open_reserved(1 << 20, 4 << 20, FIRST_FIT);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_reserved_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario33(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 33:
+     *
+     * 1. Pool is a gap of 1 MiB, with 4 MiB of address space reserved.
+     * 2. Allocate the whole pool, and write to it.
+     * 3. Allocate 1000. The pool doubles in place, and the allocation
+     *    follows the first one.
+     * 4. Allocate 3 MiB. Less than that is left of the reservation, so
+     *    the allocation fails, and the pool is unchanged.
+     * 5. Deallocate both allocations. The pool is one gap.
+     */
+
+    assert_null(mem_new_alloc(pool, 0));
+    assert_null(mem_pool_open_reserved(1 << 20, 4 << 20, BUDDY));
+    assert_null(mem_pool_open_reserved(4 << 20, 1 << 20, FIRST_FIT));
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 1 << 20);
+    assert_non_null(alloc0);
+    alloc0->mem[0] = 1;
+    alloc0->mem[(1 << 20) - 1] = 1;
+
+    alloc_pt alloc1 = mem_new_alloc(pool, 1000);
+    assert_non_null(alloc1);
+    assert_ptr_equal(alloc1->mem, pool->mem + (1 << 20));
+    alloc1->mem[999] = 1;
+
+    pool_segment_t exp1[3] =
+            {
+                    {1 << 20, 1},
+                    {1000, 1},
+                    {(1 << 20) - 1000, 0}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, FIRST_FIT, 2 << 20, (1 << 20) + 1000, 2, 1);
+
+
+    assert_null(mem_new_alloc(pool, 3 << 20));
+    check_pool(pool, exp1);
+    check_metadata(pool, FIRST_FIT, 2 << 20, (1 << 20) + 1000, 2, 1);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+
+    pool_segment_t exp2[1] =
+            {
+                    {2 << 20, 0}
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, FIRST_FIT, 2 << 20, 0, 0, 1);
+}
+
+/*******************************************/
+/***         19. DECOMMIT SCENARIOS      ***/
+/*******************************************/
+
+static int pool_decommit_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Reserving %lu bytes for a pool of %lu bytes with policy %s\n",
+         (long) (4 << 20), (long) (1 << 20), "FIRST_FIT");
+    pool = mem_pool_open_reserved(1 << 20, 4 << 20, FIRST_FIT);
+    assert_non_null(pool);
+
+    status = mem_pool_decommit_gaps(pool, 64 << 10);
+    assert_int_equal(status, ALLOC_OK);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_decommit_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario34(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 34:
+     *
+     * 1. Pool is a gap of 1 MiB, with 4 MiB of address space reserved,
+     *    none of it committed. Up to 64 KiB of free memory is retained.
+     * 2. Allocate 512 KiB twice. The first 1 MiB is committed.
+     * 3. Deallocate the second allocation. Its pages are decommitted.
+     * 4. Allocate 256 KiB. It reaches decommitted pages, which count as
+     *    committed again.
+     * 5. Deallocate the first allocation. Its pages are decommitted.
+     * 6. Allocate and deallocate 64 KiB. Not more than the retained
+     *    bytes have been freed, so its pages stay committed.
+     * 7. Deallocate the 256 KiB. All the pages are decommitted.
+     */
+
+    assert_int_equal(pool->committed_size, 0);
+    assert_int_equal(pool->reserved_size, 4 << 20);
+    assert_int_equal(mem_pool_decommit_gaps(pool, 0), ALLOC_FAIL);
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 512 << 10);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, 512 << 10);
+    assert_non_null(alloc1);
+    assert_int_equal(pool->committed_size, 1 << 20);
+
+
+    status = mem_del_alloc(pool, alloc1);
+    assert_int_equal(status, ALLOC_OK);
+    assert_int_equal(pool->committed_size, 512 << 10);
+
+
+    alloc_pt alloc2 = mem_new_alloc(pool, 256 << 10);
+    assert_non_null(alloc2);
+    alloc2->mem[(256 << 10) - 1] = 1;
+    assert_int_equal(pool->committed_size, 768 << 10);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    assert_int_equal(pool->committed_size, 256 << 10);
+
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 64 << 10);
+    assert_non_null(alloc3);
+    assert_int_equal(pool->committed_size, 320 << 10);
+    status = mem_del_alloc(pool, alloc3);
+    assert_int_equal(status, ALLOC_OK);
+    assert_int_equal(pool->committed_size, 320 << 10);
+
+
+    status = mem_del_alloc(pool, alloc2);
+    assert_int_equal(status, ALLOC_OK);
+    assert_int_equal(pool->committed_size, 0);
+
+    pool_segment_t exp[1] =
+            {
+                    {1 << 20, 0}
+            };
+    check_pool(pool, exp);
+    check_metadata(pool, FIRST_FIT, 1 << 20, 0, 0, 1);
+}
+
+/*******************************************/
+/***         20. HUGE PAGE SCENARIOS     ***/
+/*******************************************/
+
+static int pool_huge_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Mapping pool of %lu bytes on huge pages with policy %s\n", (long) POOL_SIZE, "BEST_FIT");
+    pool = mem_pool_open_huge(POOL_SIZE, BEST_FIT);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_huge_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario35(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 35:
+     *
+     * 1. Pool is a gap, mapped on a whole huge page, and aligned to it.
+     *    Which huge pages back it (if any) depends on the system.
+     * 2. Allocate the whole pool, and write to it.
+     * 3. Allocate 1 byte. The pool doesn't grow into the rest of the
+     *    huge page, so the allocation fails.
+     * 4. Deallocate the allocation.
+     */
+
+    assert_int_not_equal(pool->backing, MALLOC_BACKED);
+    assert_int_equal((uintptr_t) pool->mem % (2 << 20), 0);
+    assert_int_equal(pool->reserved_size, 2 << 20);
+    assert_int_equal(pool->committed_size, 2 << 20);
+    check_metadata(pool, BEST_FIT, POOL_SIZE, 0, 0, 1);
+
+    alloc_pt alloc0 = mem_new_alloc(pool, POOL_SIZE);
+    assert_non_null(alloc0);
+    alloc0->mem[0] = 1;
+    alloc0->mem[POOL_SIZE - 1] = 1;
+
+    assert_null(mem_new_alloc(pool, 1));
+
+    pool_segment_t exp1[1] =
+            {
+                    {POOL_SIZE, 1}
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, BEST_FIT, POOL_SIZE, POOL_SIZE, 1, 0);
+
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+    check_metadata(pool, BEST_FIT, POOL_SIZE, 0, 0, 1);
+}
+
+/*******************************************/
+/***         21. HUGE_FIT SCENARIOS      ***/
+/*******************************************/
+
+static int pool_huge_fit_setup(void **state) {
+    alloc_status status;
+    pool_pt pool = NULL;
+
+    status = mem_init();
+    assert_int_equal(status, ALLOC_OK);
+
+    INFO("Mapping pool of %lu bytes on huge pages with policy %s\n", (long) (4 << 20), "HUGE_FIT");
+    pool = mem_pool_open_huge(4 << 20, HUGE_FIT);
+    assert_non_null(pool);
+
+    *state = pool;
+
+    return 0;
+}
+
+static int pool_huge_fit_teardown(void **state) {
+    pool_pt pool = *state;
+    alloc_status status;
+
+    INFO("Closing pool\n");
+    status = mem_pool_close(pool);
+    assert_int_equal(status, ALLOC_OK);
+
+    status = mem_free();
+    assert_int_equal(status, ALLOC_OK);
+
+    return 0;
+}
+
+static void test_pool_scenario36(void **state) {
+    alloc_status status;
+    pool_pt pool = *state;
+
+    /*
+     * Scenario 36:
+     *
+     * 1. Pool is a gap, spanning two huge pages.
+     * 2. Allocate 2M and 1M. The first page is full, and the second
+     *    page has 1M in use.
+     * 3. Deallocate the 2M. The first page is empty.
+     * 4. Allocate 100. It goes to the second page, which is in use,
+     *    past the 1M, rather than to the lowest gap, in the empty page.
+     * 5. Allocate 1.5M. It doesn't fit in the second page, so it goes
+     *    to the lowest gap, in the first page.
+     * 6. Clean up.
+     */
+
+    const size_t MiB = 1 << 20;
+
+    check_metadata(pool, HUGE_FIT, 4 * MiB, 0, 0, 1);
+
+    alloc_pt alloc0 = mem_new_alloc(pool, 2 * MiB);
+    assert_non_null(alloc0);
+    alloc_pt alloc1 = mem_new_alloc(pool, MiB);
+    assert_non_null(alloc1);
+
+    status = mem_del_alloc(pool, alloc0);
+    assert_int_equal(status, ALLOC_OK);
+
+
+    alloc_pt alloc2 = mem_new_alloc(pool, 100);
+    assert_non_null(alloc2);
+    assert_ptr_equal(alloc2->mem, pool->mem + 3 * MiB);
+    pool_segment_t exp1[4] =
+            {
+                    {2 * MiB, 0},
+                    {MiB, 1},
+                    {100, 1},
+                    {MiB - 100, 0},
+            };
+    check_pool(pool, exp1);
+    check_metadata(pool, HUGE_FIT, 4 * MiB, MiB + 100, 2, 2);
+
+
+    alloc_pt alloc3 = mem_new_alloc(pool, 3 * MiB / 2);
+    assert_non_null(alloc3);
+    assert_ptr_equal(alloc3->mem, pool->mem);
+    pool_segment_t exp2[5] =
+            {
+                    {3 * MiB / 2, 1},
+                    {MiB / 2, 0},
+                    {MiB, 1},
+                    {100, 1},
+                    {MiB - 100, 0},
+            };
+    check_pool(pool, exp2);
+    check_metadata(pool, HUGE_FIT, 4 * MiB, 5 * MiB / 2 + 100, 3, 2);
+
+
+    // clean up
+    assert_int_equal(mem_del_alloc(pool, alloc1), ALLOC_OK);
+    assert_int_equal(mem_del_alloc(pool, alloc2), ALLOC_OK);
+    assert_int_equal(mem_del_alloc(pool, alloc3), ALLOC_OK);
+    check_metadata(pool, HUGE_FIT, 4 * MiB, 0, 0, 1);
+}
+
+/*******************************************/
+/***         22. STRESS TEST             ***/
 /*******************************************/
 
-void test_pool_stresstest(void **state) {
+static void test_pool_stresstest(void **state) {
     (void) state; /* unused */
 
     const unsigned num_pools = 200;
@@ -2335,17 +4325,15 @@ void test_pool_stresstest(void **state) {
 
 
     pool_pt pools[num_pools];
-    alloc_pt allocations[num_pools][num_allocations];
+    char *allocations[num_pools][num_allocations];
 
     /*
-     * NOTE: This will work iff the address of the allocation
-     * in the pool is returned to the user instead of the
-     * address of the allocation record. Since allocation records
-     * are a part of the nodes, when the node heap is reallocated
-     * the node addresses shift with it, and so do the allocation
-     * record addresses. The allocation addresses on the pool
-     * remain the same, however, so they can be returned to the
-     * user and gotten from the user upon request for deletion.
+     * NOTE: This uses the address of the allocation in the pool
+     * instead of the address of the allocation record, so that it
+     * also exercises the address index, through which
+     * mem_del_alloc_addr finds the allocation to delete. (The
+     * allocation records themselves stay put as the node heap
+     * grows by chunks, see test_pool_record_stability.)
      */
 
     /*
@@ -2369,7 +4357,7 @@ void test_pool_stresstest(void **state) {
         unsigned allocated = 0;
         for (unsigned aix=0; aix < num_allocations; ++aix) {
             allocations[pix][aix] =
-                    mem_new_alloc(pools[pix], (aix + 1) * min_alloc_size);
+                    mem_new_alloc_addr(pools[pix], (aix + 1) * min_alloc_size);
             allocated += (aix + 1) * min_alloc_size;
             if (!allocations[pix][aix]) {
                 INFO("ASSERT WILL FAIL at pix = %u, aix = %u, allocated = %u\n", pix, aix, allocated);
@@ -2380,7 +4368,7 @@ void test_pool_stresstest(void **state) {
         for (unsigned aix=0; aix < num_allocations; ++aix) {
             if (aix % 2) {
                 assert_int_equal(
-                        mem_del_alloc(pools[pix], allocations[pix][aix]),
+                        mem_del_alloc_addr(pools[pix], allocations[pix][aix]),
                         ALLOC_OK);
                 allocations[pix][aix] = NULL;
             }
@@ -2394,7 +4382,7 @@ void test_pool_stresstest(void **state) {
             if (allocations[pix][aix]) {
                 // delete allocation
                 assert_int_equal(
-                    mem_del_alloc(pools[pix], allocations[pix][aix]),
+                    mem_del_alloc_addr(pools[pix], allocations[pix][aix]),
                     ALLOC_OK);
             }
         }
@@ -2407,8 +4395,119 @@ void test_pool_stresstest(void **state) {
 }
 
 
+static void test_pool_record_stability(void **state) {
+    (void) state; /* unused */
+
+    const unsigned num_allocations = 1000;
+    const unsigned min_alloc_size = 10;
+
+    alloc_pt allocations[num_allocations];
+    char *addresses[num_allocations];
+
+    /*
+     * The node heap grows many times over while these allocations
+     * are made. The allocation records handed out before the growth
+     * have to stay valid and unchanged until they are deallocated.
+     */
+
+    assert_int_equal(mem_init(), ALLOC_OK);
+
+    pool_pt pool = mem_pool_open(POOL_SIZE * 10, FIRST_FIT);
+    assert_non_null(pool);
+
+    for (unsigned aix=0; aix < num_allocations; ++aix) {
+        allocations[aix] = mem_new_alloc(pool, (aix + 1) * min_alloc_size);
+        assert_non_null(allocations[aix]);
+        addresses[aix] = allocations[aix]->mem;
+    }
+    for (unsigned aix=0; aix < num_allocations; ++aix) {
+        assert_true(allocations[aix]->mem == addresses[aix]);
+        assert_int_equal(allocations[aix]->size, (aix + 1) * min_alloc_size);
+    }
+    for (unsigned aix=0; aix < num_allocations; ++aix) {
+        assert_int_equal(mem_del_alloc(pool, allocations[aix]), ALLOC_OK);
+    }
+    assert_int_equal(pool->num_gaps, 1);
+
+    assert_int_equal(mem_pool_close(pool), ALLOC_OK);
+    assert_int_equal(mem_free(), ALLOC_OK);
+}
+
+static void test_pool_mark_rejected(void **state) {
+    (void) state; /* unused */
+
+    /*
+     * Only ARENA and LIFO pools have a top to mark. A mark of any
+     * other pool, or of no pool, is zero.
+     */
+
+    assert_int_equal(mem_init(), ALLOC_OK);
+
+    pool_pt pool = mem_pool_open(POOL_SIZE, FIRST_FIT);
+    assert_non_null(pool);
+    alloc_pt alloc = mem_new_alloc(pool, 100);
+    assert_non_null(alloc);
+
+    pool_mark_t mark = mem_pool_mark(pool);
+    assert_int_equal(mark.alloc_size, 0);
+    assert_int_equal(mark.num_allocs, 0);
+    assert_int_equal(mem_pool_rollback(pool, mark), ALLOC_FAIL);
+
+    mark = mem_pool_mark(NULL);
+    assert_int_equal(mark.alloc_size, 0);
+    assert_int_equal(mark.num_allocs, 0);
+
+    assert_int_equal(mem_del_alloc(pool, alloc), ALLOC_OK);
+    assert_int_equal(mem_pool_close(pool), ALLOC_OK);
+    assert_int_equal(mem_free(), ALLOC_OK);
+}
+
+static void test_pool_reserve_metadata(void **state) {
+    (void) state; /* unused */
+
+    const unsigned num_allocations = 1000;
+    const unsigned min_alloc_size = 10;
+
+    char *addresses[num_allocations];
+
+    /*
+     * The metadata is reserved for all the allocations up front, so
+     * none of it grows while they are made. Pools without a gap
+     * index, and a zero count, are turned down.
+     */
+
+    assert_int_equal(mem_init(), ALLOC_OK);
+
+    pool_pt pool = mem_pool_open(POOL_SIZE * 10, BUDDY);
+    assert_non_null(pool);
+    assert_int_equal(mem_pool_reserve_metadata(pool, num_allocations), ALLOC_FAIL);
+    assert_int_equal(mem_pool_close(pool), ALLOC_OK);
+
+    pool = mem_pool_open(POOL_SIZE * 10, TLSF);
+    assert_non_null(pool);
+    assert_int_equal(mem_pool_reserve_metadata(pool, 0), ALLOC_FAIL);
+    assert_int_equal(mem_pool_reserve_metadata(pool, num_allocations), ALLOC_OK);
+
+    for (unsigned aix=0; aix < num_allocations; ++aix) {
+        addresses[aix] = mem_new_alloc_addr(pool, (aix % 50 + 1) * min_alloc_size);
+        assert_non_null(addresses[aix]);
+    }
+    for (unsigned aix=0; aix < num_allocations; aix += 2) {
+        assert_int_equal(mem_del_alloc_addr(pool, addresses[aix]), ALLOC_OK);
+    }
+    for (unsigned aix=1; aix < num_allocations; aix += 2) {
+        assert_int_equal(mem_del_alloc_addr(pool, addresses[aix]), ALLOC_OK);
+    }
+    assert_int_equal(pool->num_allocs, 0);
+    assert_int_equal(pool->num_gaps, 1);
+
+    assert_int_equal(mem_pool_close(pool), ALLOC_OK);
+    assert_int_equal(mem_free(), ALLOC_OK);
+}
+
+
 /*******************************************/
-/***         6. DRIVER ROUTINE           ***/
+/***        23. DRIVER ROUTINE           ***/
 /*******************************************/
 
 int run_test_suite() {
@@ -2443,14 +4542,38 @@ int run_test_suite() {
             cmocka_unit_test_setup_teardown(test_pool_scenario18, pool_bf_setup, pool_bf_teardown),
             cmocka_unit_test_setup_teardown(test_pool_scenario19, pool_bf_setup, pool_bf_teardown),
 
-            // do not uncomment until the project is changed to return the allocation address
-//            cmocka_unit_test(test_pool_stresstest),
+            cmocka_unit_test_setup_teardown(test_pool_scenario20, pool_tlsf_setup, pool_tlsf_teardown),
+
+            cmocka_unit_test_setup_teardown(test_pool_scenario21, pool_buddy_setup, pool_buddy_teardown),
+
+            cmocka_unit_test_setup_teardown(test_pool_scenario22, pool_fixed_setup, pool_fixed_teardown),
+
+            cmocka_unit_test_setup_teardown(test_pool_scenario23, pool_arena_setup, pool_arena_teardown),
+
+            cmocka_unit_test_setup_teardown(test_pool_scenario24, pool_lifo_setup, pool_lifo_teardown),
+
+            cmocka_unit_test_setup_teardown(test_pool_scenario25, pool_ring_setup, pool_ring_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario26, pool_bitmap_setup, pool_bitmap_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario27, pool_slab_setup, pool_slab_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario28, pool_tagged_setup, pool_tagged_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario29, pool_deferred_setup, pool_deferred_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario30, pool_next_fit_setup, pool_next_fit_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario31, pool_worst_fit_setup, pool_worst_fit_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario32, pool_growable_setup, pool_growable_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario33, pool_reserved_setup, pool_reserved_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario34, pool_decommit_setup, pool_decommit_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario35, pool_huge_setup, pool_huge_teardown),
+            cmocka_unit_test_setup_teardown(test_pool_scenario36, pool_huge_fit_setup, pool_huge_fit_teardown),
+
+            cmocka_unit_test(test_pool_stresstest),
+            cmocka_unit_test(test_pool_record_stability),
+            cmocka_unit_test(test_pool_reserve_metadata),
+            cmocka_unit_test(test_pool_mark_rejected),
     };
 
     return cmocka_run_group_tests_name("pool_test_suite", tests, NULL, NULL);
 }
 
 /* future editions */
-// TODO stress test: many pools, many allocations, many gaps (requires project refactoring, see NOTE in test body)
 // TODO test memory leaks: any way to do it w/o having to rewrite the source file?
 // TODO fix the final PASSED line of std::cerr output to the end of the file (?)